@@ -3,14 +3,14 @@
 #define OLC_SOUNDWAVE
 #include <olcSoundWaveEngine.h>
 
-bool static DEBUG = false;
-
 #include "src/game.cc"
 
-int main()
+int main(int argc, char **argv)
 {
+    if (argc > 1 && std::string(argv[1]) == "--batch")
+        return RunBatch(argc, argv);
+
     QuestForTrueColor game;
-    srand(time(NULL));
 
     if (game.Construct(SCREEN_WIDTH, SCREEN_HEIGHT, 2, 2, true))
         game.Start();
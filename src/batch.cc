@@ -0,0 +1,277 @@
+#pragma region Batch
+
+/**
+ * Keys a batch input can hold down, one bit each.
+ */
+enum class BatchKey : uint8_t
+{
+    Up,
+    Down,
+    Left,
+    Right,
+    Enter,
+    Spray,
+    Item1,
+    Item2,
+    Item3,
+    Count,
+};
+
+constexpr olc::Key BatchKeyCodes[] = {olc::Key::UP, olc::Key::DOWN, LEFT_KEY, RIGHT_KEY, olc::Key::SPACE, olc::Key::X, olc::Key::K1, olc::Key::K2, olc::Key::K3};
+
+using BatchKeys = std::bitset<static_cast<size_t>(BatchKey::Count)>;
+
+/**
+ * Picks the keys held down during a frame of a world.
+ */
+using BatchInput = std::function<BatchKeys(GameContext &context, uint64_t frame)>;
+
+/**
+ * @brief RandomInput
+ * Plays like a restless player: walks one way for a while, jumps now and
+ * then and mashes Enter through dialogs. Draws from the world's random
+ * numbers, so a seed replays the same run.
+ */
+struct RandomInput
+{
+    BatchKey walking = BatchKey::Count;
+    uint64_t walkUntil = 0;
+
+    BatchKeys operator()(GameContext &context, uint64_t frame)
+    {
+        if (frame >= walkUntil)
+        {
+            int choice = context.randomInt(3);
+            walking = choice == 0 ? BatchKey::Left : choice == 1 ? BatchKey::Right : BatchKey::Count;
+            walkUntil = frame + 15 + context.randomInt(90);
+        }
+
+        BatchKeys keys;
+
+        if (walking != BatchKey::Count)
+            keys.set(static_cast<size_t>(walking));
+
+        keys.set(static_cast<size_t>(BatchKey::Up), context.randomInt(20) == 0);
+        keys.set(static_cast<size_t>(BatchKey::Enter), context.randomInt(30) == 0);
+        keys.set(static_cast<size_t>(BatchKey::Spray), context.randomInt(10) == 0);
+        return keys;
+    }
+};
+
+struct BatchOptions
+{
+    size_t worlds = 32;
+    uint64_t frames = 60 * 60;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string level = "level_1";
+    uint32_t seed = 1;
+
+    /**
+     * Coins scattered over a copy of the level on top of its own spawns, to
+     * benchmark the node update loops far past what real levels hold.
+     */
+    size_t coins = 0;
+    float frameTime = 1.0f / 60.0f;
+
+    /**
+     * Input of every world, RandomInput when empty. Each world gets a copy.
+     */
+    BatchInput input;
+};
+
+struct BatchReport
+{
+    size_t worlds = 0;
+    uint64_t frames = 0;
+    uint64_t gameOvers = 0;
+    double seconds = 0.0;
+
+    /**
+     * Simulated frames per wall clock second, all worlds together.
+     */
+    double framesPerSecond() const
+    {
+        return seconds > 0.0 ? frames / seconds : 0.0;
+    }
+};
+
+/**
+ * @brief BatchWorld
+ * One headless game: its own context, UI and GameNode, fed keys the way
+ * QuestForTrueColor feeds them from the keyboard.
+ */
+class BatchWorld
+{
+private:
+    // Declared in the order they depend on each other, the game goes first
+    GameContext context;
+    std::unique_ptr<UINode> uiNode;
+    std::unique_ptr<GameNode> gameNode;
+    BatchKeys previous;
+
+public:
+    uint64_t gameOvers = 0;
+
+    BatchWorld(const GameData &data, const std::string &level, uint32_t seed) : context(nullptr, nullptr, seed)
+    {
+        uiNode.reset(CheckNodeType(new UINode(nullptr)));
+        gameNode.reset(CheckNodeType(new GameNode(context, uiNode.get(), data)));
+        uiNode->game = gameNode.get();
+        gameNode->setStartLevel(level);
+        gameNode->onCreated();
+    }
+
+    GameContext &getContext()
+    {
+        return context;
+    }
+
+    void step(BatchKeys keys, float fElapsedTime)
+    {
+        for (size_t i = 0; i < keys.size(); i++)
+            context.setKey(BatchKeyCodes[i], {keys[i] && !previous[i], !keys[i] && previous[i], keys[i]});
+
+        previous = keys;
+
+        if (keys[static_cast<size_t>(BatchKey::Up)])
+            gameNode->handleInput(InputAction::Up);
+
+        if (keys[static_cast<size_t>(BatchKey::Down)])
+            gameNode->handleInput(InputAction::Down);
+
+        if (keys[static_cast<size_t>(BatchKey::Left)])
+            gameNode->handleInput(InputAction::Left);
+
+        if (keys[static_cast<size_t>(BatchKey::Right)])
+            gameNode->handleInput(InputAction::Right);
+
+        if (context.Pressed(olc::Key::SPACE))
+            gameNode->handleInput(InputAction::Enter);
+
+        gameNode->onUpdated(fElapsedTime);
+
+        // What ESC and New Game do for a player, only the world's state is reset
+        if (gameNode->isGameOver)
+        {
+            gameOvers++;
+            gameNode->onCreated();
+        }
+    }
+};
+
+/**
+ * @brief BatchRunner
+ * Simulates many independent headless worlds at uncapped speed, spread over
+ * a pool of threads. A world is created, run and destroyed by one thread,
+ * which is what keeps the per-thread node tables apart; the threads only
+ * share a counter to take the next world from.
+ */
+class BatchRunner
+{
+private:
+    BatchOptions options;
+
+public:
+    explicit BatchRunner(BatchOptions options) : options(std::move(options))
+    {
+    }
+
+    BatchReport run()
+    {
+        std::atomic<size_t> nextWorld = 0;
+        std::atomic<uint64_t> frames = 0;
+        std::atomic<uint64_t> gameOvers = 0;
+
+        // Parsed once and only read after, every world shares it
+        GameData data;
+        data.load();
+
+        auto level = options.level;
+        if (options.coins > 0)
+        {
+            std::mt19937 random(options.seed);
+            auto base = data.world.findLevel(level);
+
+            if (base != NoLevel)
+                level = data.world.levels[data.world.addCrowdedLevel(base, options.coins, random)].name;
+        }
+
+        auto worker = [&]()
+        {
+            for (size_t i = nextWorld++; i < options.worlds; i = nextWorld++)
+            {
+                BatchWorld world(data, level, options.seed + static_cast<uint32_t>(i));
+                BatchInput input = options.input ? options.input : BatchInput(RandomInput());
+
+                for (uint64_t frame = 0; frame < options.frames; frame++)
+                    world.step(input(world.getContext(), frame), options.frameTime);
+
+                frames += options.frames;
+                gameOvers += world.gameOvers;
+            }
+        };
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> pool;
+        size_t threads = std::clamp<size_t>(options.threads, 1, std::max<size_t>(options.worlds, 1));
+
+        for (size_t i = 0; i < threads; i++)
+            pool.emplace_back(worker);
+
+        for (auto &thread : pool)
+            thread.join();
+
+        BatchReport report;
+        report.worlds = options.worlds;
+        report.frames = frames;
+        report.gameOvers = gameOvers;
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+};
+
+/**
+ * Runs a batch from the command line, every option is optional:
+ *
+ *     game --batch --worlds 64 --frames 36000 --threads 32 --level level_2 --seed 7
+ *
+ * Benchmarking the update loops on a level crowded with 10k coins:
+ *
+ *     game --batch --worlds 8 --threads 1 --coins 10000
+ */
+int RunBatch(int argc, char **argv)
+{
+    BatchOptions options;
+
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        std::string option = argv[i];
+        const char *value = argv[i + 1];
+
+        if (option == "--worlds")
+            options.worlds = std::strtoul(value, nullptr, 10);
+        else if (option == "--frames")
+            options.frames = std::strtoull(value, nullptr, 10);
+        else if (option == "--threads")
+            options.threads = std::strtoul(value, nullptr, 10);
+        else if (option == "--level")
+            options.level = value;
+        else if (option == "--seed")
+            options.seed = std::strtoul(value, nullptr, 10);
+        else if (option == "--coins")
+            options.coins = std::strtoul(value, nullptr, 10);
+        else
+            continue;
+
+        i++;
+    }
+
+    auto report = BatchRunner(options).run();
+
+    std::cout << report.worlds << " worlds, " << report.frames << " frames in " << report.seconds << "s" << std::endl;
+    std::cout << report.framesPerSecond() << " frames/s, " << report.gameOvers << " game overs" << std::endl;
+    return 0;
+}
+
+#pragma endregion Batch
@@ -1,78 +1,99 @@
 
 #pragma region Collectable Base
 
+/**
+ * What collectables of one type share, made by their makePrefab.
+ */
+struct CollectablePrefab : EntityPrefab
+{
+    std::string hintText = "Item";
+    Sound *sound = nullptr;
+    ClipId idleClip = NoClip;
+    ClipId collectedClip = NoClip;
+    bool autoCollect = false;
+    bool enableWiggling = true;
+};
+
 class Collectable : public EntityNode
 {
 private:
-    float deltaTime = 0.0f;
+    float wigglePhase = 0.0f;
 
 protected:
-    AnimatedAssetProvider *assetProvider = nullptr;
+    // Read every frame, ahead of what is only used on collecting. The
+    // collider is the node's body, sized from the prefab
+    const CollectablePrefab *prefab = nullptr;
+    SpriteAnimator animator;
     bool didCollect = false;
     bool enableWiggling = true;
     bool autoCollect = false;
-    PlayerNode *player = nullptr;
-    olc::utils::geom2d::rect<float> collider;
-    std::string hintText = "Item";
+    NodeRef<PlayerNode> player;
     Dialog dialog;
 
-public:
-    Collectable(const ldtk::Entity &entity, GameNode *game) : EntityNode(entity, game)
-    {
-        auto assetDrawPosition = getSpriteDrawPosition();
-        assetProvider = new AnimatedAssetProvider(position, assetDrawPosition, {1, 1}, {SPRITE_SIZE, SPRITE_SIZE}, olc::WHITE);
-        thumbnail = new AssetOptions({}, assetDrawPosition, {1, 1}, {SPRITE_SIZE, SPRITE_SIZE});
-    }
+private:
+    AssetOptions thumbnailOptions;
 
-    ~Collectable() override
+public:
+    Collectable(const EntitySpawn &spawn, GameNode *game) : EntityNode(spawn, game)
     {
-        delete assetProvider;
+        declareType<Collectable>();
+        thumbnailOptions = AssetOptions({}, getSpriteDrawPosition(), {1, 1}, {SPRITE_SIZE, SPRITE_SIZE});
+        thumbnail = &thumbnailOptions;
     }
 
     void onCreated() override
     {
         EntityNode::onCreated();
 
-        collider = olc::utils::geom2d::rect<float>(position, {SPRITE_SIZE, SPRITE_SIZE});
-        deltaTime = rand() % 100 / 100.0f;
-        dialog = {"Press SPACE to collect items", 3.0f};
-        collider.pos = position;
+        prefab = &game->getPrefabs().get<CollectablePrefab>(getTypeId(), [this](CollectablePrefab &prefab)
+                                                            { buildPrefab(prefab); });
+
+        // Stamped from the prefab, nothing here allocates
+        animator = prefab->animator;
+        animator.setOffset(getSpriteDrawPosition());
+        autoCollect = prefab->autoCollect;
+        enableWiggling = prefab->enableWiggling;
+
+        // Lying around off screen there is nothing to update
+        game->getBodies().resize(body, prefab->colliderSize);
+        game->getBodies().set(body, LevelBodies::Culled, true);
+        wigglePhase = getContext().randomFloat();
+        dialog = {Message("CollectHint"), 3.0f};
+
+        // Coins, portals and checkpoints are picked up by touching them
+        if (!autoCollect)
+            game->getInput().subscribe(InputAction::Enter, this, InputPriority::Item);
     }
 
     void onUpdated(float fElapsedTime) override
     {
         EntityNode::onUpdated(fElapsedTime);
-        didCollect = this->parent != nullptr;
+        didCollect = getParent() != nullptr;
 
         if (!camera->IsOnScreen(position))
         {
             return;
         }
 
+        auto *player = this->player.get();
         if (didCollect && player != nullptr && !player->isSelected(this))
         {
             onIsNotActive(fElapsedTime);
             return;
         }
 
-        if (deltaTime > 1.0f)
-        {
-            deltaTime = 0.0f;
-        }
-
-        collider.pos = position;
-        assetProvider->Update(fElapsedTime);
-        deltaTime += fElapsedTime;
+        animator.Update(fElapsedTime);
 
         auto drawPosition = this->position;
         camera->WorldToScreen(drawPosition);
-        auto *options = assetProvider->GetAssetOptions();
+        auto *options = animator.GetAssetOptions();
         options->position = drawPosition;
 
         if (enableWiggling)
-            options->position.y -= 5 * std::sin(2 * 3.14 * deltaTime);
+            options->position.y -= 5 * std::sin(2 * 3.14 * (game->getTime() + wigglePhase));
 
-        auto textSize = TextSize(hintText);
+        auto &hintText = prefab->hintText;
+        auto textSize = getContext().TextSize(hintText);
         auto hintPosition = options->position;
         hintPosition.y -= 30;
         hintPosition.x += SPRITE_SIZE * 0.5;
@@ -84,13 +105,13 @@ public:
 
             if (!autoCollect)
             {
-                if (!this->game->getFlag("KnowsHowToCollect"))
+                if (!this->game->getFlag(Flag("KnowsHowToCollect")))
                 {
                     this->game->addDialog(dialog);
-                    this->game->setFlag("KnowsHowToCollect", true);
+                    this->game->setFlag(Flag("KnowsHowToCollect"), true);
                 }
 
-                Text(hintText, olc::WHITE, hintPosition);
+                getContext().Text(hintText, olc::WHITE, hintPosition);
             }
         }
 
@@ -102,6 +123,12 @@ public:
 
     virtual void onIsNotActive(float fElapsedTime) {}
 
+    /**
+     * Fills in the prefab of this node's class, called once per world by
+     * the first node of the class to be created.
+     */
+    virtual void makePrefab([[maybe_unused]] CollectablePrefab &prefab) {}
+
     void onEnter() override
     {
 
@@ -112,22 +139,35 @@ public:
 
         if (isCollidingWithPlayer())
         {
-            bool isStorageFull = player->isStorageFull();
+            bool isStorageFull = getPlayer()->isStorageFull();
 
             if (isStorageFull)
             {
-                this->game->addDialog({"Can't store any more items.\nDrop the current item by pressing arrow down.", 2.0f});
+                this->game->addDialog({Message("StorageFull"), 2.0f});
                 return;
             }
 
-            this->game->setFlag("KnowsHowToCollect", true);
+            this->game->setFlag(Flag("KnowsHowToCollect"), true);
             onCollected();
         }
     }
 
+    void onSnapshot(SnapshotWriter &writer) const override
+    {
+        EntityNode::onSnapshot(writer);
+        writer.write(enableWiggling);
+    }
+
+    void onRestore(SnapshotReader &reader) override
+    {
+        EntityNode::onRestore(reader);
+        reader.read(enableWiggling);
+        didCollect = getParent() != nullptr;
+    }
+
     void onReparent() override
     {
-        if (!this->parent)
+        if (!getParent())
         {
             position.x = std::round(position.x / SPRITE_SIZE) * SPRITE_SIZE;
             position.y = std::round(position.y / SPRITE_SIZE) * SPRITE_SIZE;
@@ -137,19 +177,28 @@ public:
         }
     }
 
-    bool isCollidingWithPlayer()
+    /**
+     * The level's player, looked up again if the cached one was destroyed.
+     */
+    PlayerNode *getPlayer()
     {
+        auto *player = this->player.get();
+
         if (!player)
         {
             player = game->getChild<PlayerNode>();
+            this->player = player;
         }
 
-        if (!player)
-        {
-            return false;
-        }
+        return player;
+    }
 
-        return overlaps(collider, player->getCollider());
+    /**
+     * As of the last logic phase, which tests every body against the player.
+     */
+    bool isCollidingWithPlayer()
+    {
+        return game->getBodies().is(body, LevelBodies::Touching);
     }
 
     virtual bool canCollect()
@@ -161,13 +210,14 @@ public:
 
     virtual void Render(float fDeltaTime)
     {
-        Image(spritesProvider, assetProvider->GetAssetOptions());
+        getContext().Image(spritesProvider, animator.GetAssetOptions());
 
-        if (DEBUG)
+        if (getContext().debug)
         {
+            auto collider = game->getBodies().getCollider(body);
             auto pos = collider.pos;
             this->camera->WorldToScreen(pos);
-            Rect(pos, collider.size, olc::WHITE);
+            getContext().Rect(pos, collider.size, olc::WHITE);
         }
     }
 
@@ -181,7 +231,7 @@ public:
         if (!autoCollect)
             enableWiggling = false;
 
-        reparent(player);
+        game->queueReparent(this, getPlayer());
     }
 
     virtual void onCanCollect()
@@ -191,6 +241,14 @@ public:
             onCollected();
         }
     }
+
+private:
+    void buildPrefab(CollectablePrefab &prefab)
+    {
+        makePrefab(prefab);
+        prefab.animator = SpriteAnimator(&prefab.clips, getSpriteDrawPosition());
+        prefab.animator.Play(prefab.idleClip);
+    }
 };
 
 #pragma endregion
@@ -200,19 +258,26 @@ public:
 class TinyPurseNode : public Collectable
 {
 public:
-    TinyPurseNode(const ldtk::Entity &entity, GameNode *game) : Collectable(entity, game)
+    TinyPurseNode(const EntitySpawn &spawn, GameNode *game) : Collectable(spawn, game)
+    {
+        declareType<TinyPurseNode>();
+    }
+
+    void makePrefab(CollectablePrefab &prefab) override
     {
-        hintText = "Tiny Purse";
+        prefab.hintText = "Tiny Purse";
     }
 
     void onCollected() override
     {
-        this->game->removeChild(this);
-        this->player->expandStorage(2);
-        this->game->addDialog({"Now you can store stuff in your tiny purse", 2.0f});
+        if (isDestroyed())
+            return;
+
+        this->game->destroyNode(this);
+        getPlayer()->expandStorage(spawn.getFields<PurseFields>().slots);
+        this->game->addDialog({Message("PurseCollected"), 2.0f});
     }
 };
-REGISTER_NODE_TYPE(TinyPurseNode, "purse")
 
 #pragma endregion
 
@@ -248,34 +313,49 @@ private:
     const uint8_t PARTICLE_COUNT = 80;
     const uint8_t EMISSION_RATE = 40;
     const uint8_t EMISSION_PER_SETUP = 8;
-    Sound *spraySfx = nullptr;
 
     uint8_t emitted = 0;
     float deltaLastEmission = 0.0f;
 
 public:
-    BugSprayNode(const ldtk::Entity &entity, GameNode *game) : Collectable(entity, game)
+    BugSprayNode(const EntitySpawn &spawn, GameNode *game) : Collectable(spawn, game)
     {
-        hintText = "Bug Spray";
+        declareType<BugSprayNode>();
         particles.reserve(PARTICLE_COUNT);
     }
 
-    void onCreated() override
+    void makePrefab(CollectablePrefab &prefab) override
     {
-        Collectable::onCreated();
-        spraySfx = new Sound("assets/sfx/spray.wav", 1);
+        prefab.hintText = "Bug Spray";
+        prefab.sound = prefab.loadSound(getContext(), "assets/sfx/spray.wav", 1);
     }
 
     void onCollected() override
     {
         Collectable::onCollected();
-        if (!this->game->getFlag("KnowsHowToUseBugSpray"))
+        if (!this->game->getFlag(Flag("KnowsHowToUseBugSpray")))
         {
-            this->game->addDialog({"You can use the " + hintText + " by pressing X", 2.0f, false, false, 10});
-            this->game->setFlag("KnowsHowToUseBugSpray", true);
+            this->game->addDialog({Message("BugSprayHint"), 2.0f, false, false, 10});
+            this->game->setFlag(Flag("KnowsHowToUseBugSpray"), true);
         }
 
+        resetParticles();
+    }
+
+    void onRestore(SnapshotReader &reader) override
+    {
+        Collectable::onRestore(reader);
+
+        // Sprays spawned again by the restore didn't go through onCollected
+        if (didCollect)
+            resetParticles();
+    }
+
+    void resetParticles()
+    {
         particles.clear();
+        emitted = 0;
+        deltaLastEmission = 0.0f;
 
         for (int i = 0; i < PARTICLE_COUNT; i++)
             particles.emplace_back(olc::vf2d{0, 0}, olc::vf2d{0, 0}, 0.0f);
@@ -295,11 +375,11 @@ public:
 
             deltaLastEmission = 0.0f;
 
-            float angle = ((rand() % 45) - 22.5f) * 3.14159f / 180.0f;
-            auto direction = player->getDirection();
-            olc::vf2d vel = rotateVector(direction, angle) * (float)(rand() % 100 + 50);
+            float angle = (getContext().randomInt(45) - 22.5f) * 3.14159f / 180.0f;
+            auto direction = getPlayer()->getDirection();
+            olc::vf2d vel = rotateVector(direction, angle) * (float)(getContext().randomInt(100) + 50);
             p.position = this->position;
-            p.lifespan = (rand() % 100) / 100.0f * 2.0f + 0.1f;
+            p.lifespan = getContext().randomFloat() * 2.0f + 0.1f;
             p.velocity = vel;
         }
     }
@@ -311,14 +391,14 @@ public:
         if (game->isGameOver)
             return;
 
-        bool isHoldingSpray = Held(olc::Key::X);
+        bool isHoldingSpray = getContext().Held(olc::Key::X);
 
         if (isHoldingSpray)
         {
             deltaLastEmission += fElapsedTime;
 
-            if (!spraySfx->IsPlaying())
-                spraySfx->Play(false, true);
+            if (!prefab->sound->IsPlaying())
+                prefab->sound->Play(false, true);
         }
 
         if (aliveParticles <= EMISSION_RATE && isHoldingSpray && deltaLastEmission >= 0.05f)
@@ -337,11 +417,7 @@ private:
     uint8_t renderParticles(float fElapsedTime)
     {
         int aliveParticles = 0;
-        auto &worldOptions = game->getGameEnum("world");
-        auto &sprayPos = worldOptions["spray"];
-        auto &textureRect = sprayPos.getIconTextureRect();
-
-        olc::vf2d sprayPosition = {static_cast<float>(textureRect.x), static_cast<float>(textureRect.y)};
+        olc::vf2d sprayPosition = game->getIconPosition("spray");
         auto npcs = game->getOnScreenChildrenOfType<CoreNPC>();
 
         for (auto &particle : particles)
@@ -367,13 +443,12 @@ private:
 
             options.offset.y = particle.lifespan > 0.6f ? 0 : options.size.y;
 
-            Image(spritesProvider, &options);
+            getContext().Image(spritesProvider, &options);
         }
 
         return aliveParticles;
     }
 };
-REGISTER_NODE_TYPE(BugSprayNode, "bug_spray")
 
 #pragma endregion
 
@@ -381,44 +456,41 @@ REGISTER_NODE_TYPE(BugSprayNode, "bug_spray")
 
 class CoinNode : public Collectable
 {
-private:
-    Sound *coinUpSfx = nullptr;
-
 public:
-    CoinNode(const ldtk::Entity &entity, GameNode *game) : Collectable(entity, game)
+    CoinNode(const EntitySpawn &spawn, GameNode *game) : Collectable(spawn, game)
     {
-        hintText = "Coin";
-        enableWiggling = false;
-        autoCollect = true;
+        declareType<CoinNode>();
     }
 
-    ~CoinNode() override
+    void makePrefab(CollectablePrefab &prefab) override
     {
-        delete coinUpSfx;
+        prefab.hintText = "Coin";
+        prefab.enableWiggling = false;
+        prefab.autoCollect = true;
+        prefab.idleClip = prefab.clips.add(10.0f, {{}, {1, 0}, {2, 0}, {3, 0}, {4, 0}});
+        prefab.sound = prefab.loadSound(getContext(), "assets/sfx/coin_up.wav");
     }
 
     void onCreated() override
     {
         Collectable::onCreated();
-        assetProvider->AddAnimation("idle", 10.0, {{}, {1, 0}, {2, 0}, {3, 0}, {4, 0}});
-        assetProvider->PlayAnimation("idle", true);
 
         // Randomize the initial frame
-        float fRandomElapsedTime = rand() % 100 / 100.0f;
-        assetProvider->Update(fRandomElapsedTime);
-
-        // Loading sound effects
-        coinUpSfx = new Sound("assets/sfx/coin_up.wav");
+        float fRandomElapsedTime = getContext().randomFloat();
+        animator.Update(fRandomElapsedTime);
     }
 
     void onCollected() override
     {
-        this->game->removeChild(this);
-        this->player->addMoney(1);
-        coinUpSfx->Play(false, true);
+        // Already collected this frame, removal happens at the sync point
+        if (isDestroyed())
+            return;
+
+        this->game->destroyNode(this);
+        getPlayer()->addMoney(1);
+        prefab->sound->Play(false, true);
     }
 };
-REGISTER_NODE_TYPE(CoinNode, "coin")
 
 #pragma endregion
 
@@ -427,12 +499,16 @@ REGISTER_NODE_TYPE(CoinNode, "coin")
 class FlowerNode : public Collectable
 {
 public:
-    FlowerNode(const ldtk::Entity &entity, GameNode *game) : Collectable(entity, game)
+    FlowerNode(const EntitySpawn &spawn, GameNode *game) : Collectable(spawn, game)
     {
-        hintText = "Unknown Flower";
+        declareType<FlowerNode>();
+    }
+
+    void makePrefab(CollectablePrefab &prefab) override
+    {
+        prefab.hintText = "Unknown Flower";
     }
 };
-REGISTER_NODE_TYPE(FlowerNode, "flower")
 
 #pragma endregion
 
@@ -444,23 +520,28 @@ private:
     std::string targetLevel;
 
 public:
-    PortalNode(const ldtk::Entity &entity, GameNode *game) : Collectable(entity, game)
+    PortalNode(const EntitySpawn &spawn, GameNode *game) : Collectable(spawn, game)
+    {
+        declareType<PortalNode>();
+    }
+
+    void makePrefab(CollectablePrefab &prefab) override
     {
-        hintText = "Portal";
-        autoCollect = true;
-        enableWiggling = false;
+        prefab.hintText = "Portal";
+        prefab.autoCollect = true;
+        prefab.enableWiggling = false;
+        prefab.idleClip = prefab.clips.add(6.0f, {{0, 0}, {1, 0}, {2, 0}});
     }
 
     void onCreated() override
     {
         Collectable::onCreated();
-        assetProvider->AddAnimation("spin", 6.0f, {{0, 0}, {1, 0}, {2, 0}});
-        assetProvider->PlayAnimation("spin", true);
 
-        bool isEnabled = entity.getField<ldtk::FieldType::Bool>("enabled").value_or(false);
-        targetLevel = entity.getField<ldtk::FieldType::String>("level").value_or("");
+        auto &fields = spawn.getFields<PortalFields>();
+        if (fields.targetLevel != NoLevel)
+            targetLevel = game->getWorld().levels[fields.targetLevel].name;
 
-        if (isEnabled)
+        if (fields.enabled)
             game->enableLevelPortal();
     }
 
@@ -474,13 +555,11 @@ public:
     {
         if (game->isLevelPortalEnabled())
         {
-            game->loadLevel(targetLevel);
+            game->queueLoadLevel(targetLevel);
         }
     }
 };
 
-REGISTER_NODE_TYPE(PortalNode, "portal")
-
 #pragma endregion Portal
 
 #pragma region CheckPoint
@@ -488,29 +567,28 @@ REGISTER_NODE_TYPE(PortalNode, "portal")
 class CheckPointNode : public Collectable
 {
 private:
-    Sound *checkpointActivatedSfx = nullptr;
+    bool activated = false;
 
 public:
-    CheckPointNode(const ldtk::Entity &entity, GameNode *game) : Collectable(entity, game)
+    CheckPointNode(const EntitySpawn &spawn, GameNode *game) : Collectable(spawn, game)
     {
-        hintText = "Check Point";
-        autoCollect = true;
-        enableWiggling = false;
+        declareType<CheckPointNode>();
     }
 
-    ~CheckPointNode() override
+    void makePrefab(CollectablePrefab &prefab) override
     {
-        delete checkpointActivatedSfx;
+        prefab.hintText = "Check Point";
+        prefab.autoCollect = true;
+        prefab.enableWiggling = false;
+        prefab.idleClip = prefab.clips.add(1.0f, {{}});
+        prefab.collectedClip = prefab.clips.add(1.0f, {{1, 0}});
+        prefab.sound = prefab.loadSound(getContext(), "assets/sfx/flag_put.wav", 1);
     }
 
     void onCreated() override
     {
         Collectable::onCreated();
         position.y += 10;
-        assetProvider->AddAnimation("idle", 1.0, {{}});
-        assetProvider->AddAnimation("collected", 1.0, {{1, 0}});
-        assetProvider->PlayAnimation("idle", true);
-        checkpointActivatedSfx = new Sound("assets/sfx/flag_put.wav", 1);
     }
 
     void onCollected() override
@@ -520,15 +598,44 @@ public:
             return;
         }
 
-        checkpointActivatedSfx->Play(false, false);
+        prefab->sound->Play(false, false);
         PlayerNode *player = game->getChild<PlayerNode>();
+
+        // Touching it collects it every frame, the world is saved on arrival
+        if (player->getCheckpoint() != position)
+            game->queueCheckpoint();
+
         player->setCheckpoint(position);
-        assetProvider->PlayAnimation("collected");
+        animator.Play(prefab->collectedClip);
         didCollect = true;
+        activated = true;
     }
-};
 
-REGISTER_NODE_TYPE(CheckPointNode, "checkpoint")
+    uint8_t onStreamOut() override
+    {
+        return activated;
+    }
+
+    void onStreamIn(uint8_t state) override
+    {
+        activated = state;
+        if (activated)
+            animator.Play(prefab->collectedClip);
+    }
+
+    void onSnapshot(SnapshotWriter &writer) const override
+    {
+        Collectable::onSnapshot(writer);
+        writer.write(activated);
+    }
+
+    void onRestore(SnapshotReader &reader) override
+    {
+        Collectable::onRestore(reader);
+        reader.read(activated);
+        animator.Play(activated ? prefab->collectedClip : prefab->idleClip);
+    }
+};
 
 #pragma endregion CheckPoint
 
@@ -542,18 +649,19 @@ private:
 public:
     GemNode(GameNode *game) : CoreNode("Gem", game)
     {
+        declareType<GemNode>();
     }
 
     void onCreated() override
     {
         CoreNode::onCreated();
-        iconCoords = game->getPositionForEnumValue("world", "gem");
+        iconCoords = game->getIconPosition("gem");
     }
 
     void onUpdated(float fElapsedTime) override
     {
         AssetOptions options = AssetOptions(position, iconCoords, {1, 1}, {SPRITE_SIZE, SPRITE_SIZE});
-        Image(game->spritesProvider, &options);
+        getContext().Image(game->spritesProvider, &options);
     }
 };
 
@@ -562,9 +670,14 @@ class GemCollectableNode : public Collectable
 public:
     bool visible = false;
 
-    GemCollectableNode(const ldtk::Entity &entity, GameNode *game) : Collectable(entity, game)
+    GemCollectableNode(const EntitySpawn &spawn, GameNode *game) : Collectable(spawn, game)
     {
-        hintText = "Gem";
+        declareType<GemCollectableNode>();
+    }
+
+    void makePrefab(CollectablePrefab &prefab) override
+    {
+        prefab.hintText = "Gem";
     }
 
     void onCreated() override
@@ -575,18 +688,17 @@ public:
 
     void onUpdated(float fElapsedTime) override
     {
-        if (game->getFlag("showGem"))
+        if (game->getFlag(Flag("showGem")))
             Collectable::onUpdated(fElapsedTime);
     }
 
     void onCollected() override
     {
         Collectable::onCollected();
-        game->addDialog({"Sorry, this is all I got for now XD", 1.0f, true, true, 10});
-        game->addDialog({"Thanks for playing, though!", 1.0f, true, true, 11});
+        game->addDialog({Message("GemSorry"), 1.0f, true, true, 10});
+        game->addDialog({Message("GemThanks"), 1.0f, true, true, 11});
     }
 };
-REGISTER_NODE_TYPE(GemCollectableNode, "gem")
 
 #pragma endregion Gem
 
@@ -596,44 +708,38 @@ class ShellNode : public CoreNode
 {
 private:
     olc::vf2d iconCoords;
-    float deltaTime = 0.0f;
     olc::vf2d newPosition;
     bool isMoving = false;
-    float displayShellTime = 0.0f;
+    float displayUntil = 0.0f;
 
 public:
     ShellNode(GameNode *game) : CoreNode("Shell", game)
     {
+        declareType<ShellNode>();
     }
 
     void onCreated() override
     {
         CoreNode::onCreated();
-        iconCoords = game->getPositionForEnumValue("world", "shell");
-        deltaTime = 0;
+        iconCoords = game->getIconPosition("shell");
         newPosition = position;
     }
 
     void display()
     {
-        displayShellTime = 4.0f;
+        displayUntil = game->getTime() + 4.0f;
     }
 
-    void onUpdated(float fElapsedTime) override
+    /**
+     * Seconds left of the shell being lifted to show what's under it.
+     */
+    float getDisplayTimeLeft()
     {
-        deltaTime += fElapsedTime;
-        displayShellTime -= fElapsedTime;
-
-        if (deltaTime > 1.0f)
-        {
-            deltaTime = 0.0f;
-        }
-
-        if (displayShellTime < 0)
-        {
-            displayShellTime = 0;
-        }
+        return std::max(0.0f, displayUntil - game->getTime());
+    }
 
+    void onUpdated(float fElapsedTime) override
+    {
         if (position != newPosition)
         {
             auto diff = newPosition - position;
@@ -658,26 +764,26 @@ public:
         CoreNode::onUpdated(fElapsedTime);
         AssetOptions options = AssetOptions(position, iconCoords, {1, 1}, {SPRITE_SIZE, SPRITE_SIZE});
 
-        if (displayShellTime > 0)
+        auto displayTimeLeft = getDisplayTimeLeft();
+        if (displayTimeLeft > 0)
         {
-            options.position.y -= 40 * displayShellTime;
+            options.position.y -= 40 * displayTimeLeft;
         }
         else
         {
             options.position.y = position.y;
         }
 
-        Image(game->spritesProvider, &options);
+        getContext().Image(game->spritesProvider, &options);
     }
 
     void moveTo(olc::vf2d position)
     {
-        if (displayShellTime > 0)
+        if (getDisplayTimeLeft() > 0)
         {
             return;
         }
 
-        deltaTime = 0.0f;
         newPosition = position;
         isMoving = true;
     }
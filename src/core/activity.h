@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * @brief ActivityGrid
+ * Uniform grid over the level holding the nodes that are asleep, bucketed by
+ * the cell they fell asleep in. Waking the nodes around the camera only
+ * visits the cells the area covers, no matter how many nodes are asleep.
+ */
+class ActivityGrid
+{
+private:
+    float cellSize;
+    int columns = 0;
+    int rows = 0;
+    std::vector<std::vector<NodeHandle>> cells;
+
+public:
+    explicit ActivityGrid(float cellSize = 256.0f) : cellSize(cellSize)
+    {
+    }
+
+    /**
+     * Sizes the grid for a level. Drops every sleeping node.
+     */
+    void resize(olc::vf2d worldSize)
+    {
+        columns = std::max(1, static_cast<int>(std::ceil(worldSize.x / cellSize)));
+        rows = std::max(1, static_cast<int>(std::ceil(worldSize.y / cellSize)));
+        clear();
+        cells.resize(columns * rows);
+    }
+
+    void clear()
+    {
+        for (auto &cell : cells)
+            cell.clear();
+    }
+
+    void insert(NodeHandle node, olc::vf2d position)
+    {
+        cells[cellIndex(cellOf(position.x, columns), cellOf(position.y, rows))].push_back(node);
+    }
+
+    /**
+     * Empties the cells overlapping area, handing each handle to onWake.
+     * Handles can be stale, resolving them is up to the caller.
+     */
+    template <typename F>
+    void wake(const olc::utils::geom2d::rect<float> &area, F &&onWake)
+    {
+        if (cells.empty())
+            return;
+
+        int left = cellOf(area.pos.x, columns);
+        int right = cellOf(area.pos.x + area.size.x, columns);
+        int top = cellOf(area.pos.y, rows);
+        int bottom = cellOf(area.pos.y + area.size.y, rows);
+
+        for (int y = top; y <= bottom; y++)
+        {
+            for (int x = left; x <= right; x++)
+            {
+                auto &cell = cells[cellIndex(x, y)];
+                for (auto handle : cell)
+                    onWake(handle);
+
+                cell.clear();
+            }
+        }
+    }
+
+private:
+    int cellOf(float coordinate, int count) const
+    {
+        return std::clamp(static_cast<int>(std::floor(coordinate / cellSize)), 0, count - 1);
+    }
+
+    int cellIndex(int x, int y) const
+    {
+        return y * columns + x;
+    }
+};
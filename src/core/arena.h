@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+/**
+ * @brief LevelArena
+ * Monotonic allocator for level data that lives exactly as long as a level,
+ * like the collider rects and the level's background. Allocation is a
+ * pointer bump and reset() rewinds to the first block without giving memory
+ * back, so repeated level loads reuse the same blocks.
+ *
+ * Objects with a non-trivial destructor are recorded when created and
+ * destroyed in reverse order on reset(); trivially destructible ones cost
+ * nothing to drop.
+ */
+class LevelArena
+{
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    struct Finalizer
+    {
+        void (*destroy)(void *);
+        void *object;
+    };
+
+    std::vector<Block> blocks;
+    std::vector<Finalizer> finalizers;
+    size_t blockSize;
+    size_t currentBlock = 0;
+    size_t offset = 0;
+
+public:
+    explicit LevelArena(size_t blockSize = 64 * 1024) : blockSize(blockSize)
+    {
+    }
+
+    LevelArena(const LevelArena &) = delete;
+    LevelArena &operator=(const LevelArena &) = delete;
+
+    ~LevelArena()
+    {
+        reset();
+    }
+
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        while (currentBlock < blocks.size())
+        {
+            auto &block = blocks[currentBlock];
+            size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+
+            if (aligned + size <= block.size)
+            {
+                offset = aligned + size;
+                return block.data.get() + aligned;
+            }
+
+            currentBlock++;
+            offset = 0;
+        }
+
+        // Blocks from new[] are aligned for any fundamental type
+        size_t newBlockSize = std::max(blockSize, size);
+        blocks.push_back({std::make_unique<std::byte[]>(newBlockSize), newBlockSize});
+        currentBlock = blocks.size() - 1;
+        offset = size;
+        return blocks.back().data.get();
+    }
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        void *memory = allocate(sizeof(T), alignof(T));
+        T *object = new (memory) T(std::forward<Args>(args)...);
+
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            finalizers.push_back({[](void *p)
+                                  { static_cast<T *>(p)->~T(); },
+                                  object});
+
+        return object;
+    }
+
+    /**
+     * Destroys every object created since the last reset and rewinds to the
+     * first block. The blocks themselves are kept for the next level.
+     */
+    void reset()
+    {
+        for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it)
+            it->destroy(it->object);
+
+        finalizers.clear();
+        currentBlock = 0;
+        offset = 0;
+    }
+
+    size_t capacity() const
+    {
+        size_t total = 0;
+        for (auto &block : blocks)
+            total += block.size;
+
+        return total;
+    }
+};
@@ -1,15 +1,9 @@
 #pragma once
 
-olc::sound::WaveEngine *soundEngine = nullptr;
-
-void setSoundEngine(olc::sound::WaveEngine *engine)
-{
-    soundEngine = engine;
-}
-
 class Sound
 {
 private:
+    olc::sound::WaveEngine *engine = nullptr;
     int channel;
     bool played = false;
     bool didStop = false;
@@ -17,10 +11,24 @@ private:
     olc::sound::PlayingWave playingWave = {};
 
 public:
-    Sound(std::string path, int channel = 0)
+    /**
+     * Plays through the context's audio engine. Without one the sound is
+     * never loaded and stays silent.
+     */
+    Sound(GameContext &context, std::string path, int channel = 0)
     {
+        this->engine = context.audio;
         this->channel = channel;
-        wave = {path};
+
+        if (engine)
+            wave = {path};
+    }
+
+    ~Sound()
+    {
+        // The engine mixes straight from our wave, so it can't outlive us
+        if (IsPlaying())
+            engine->StopWaveform(playingWave);
     }
 
     void SetPlayed(bool played)
@@ -39,8 +47,11 @@ public:
             Stop();
         }
 
+        if (!engine)
+            return;
+
         played = true;
-        this->playingWave = soundEngine->PlayWaveform(&wave, repeat, 1.0f);
+        this->playingWave = engine->PlayWaveform(&wave, repeat, 1.0f);
     }
 
     void Stop()
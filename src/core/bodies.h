@@ -0,0 +1,201 @@
+#pragma once
+
+/**
+ * @brief LevelBodies
+ * The per-frame state of the level's entities in parallel arrays: where
+ * each one stands, the size of its collider and a few flags. The logic
+ * phase marks which bodies are on screen and which touch the player, and
+ * the activity pass puts the far ones to sleep, each in one walk over the
+ * arrays that doesn't touch the nodes.
+ *
+ * Bodies are named by id. Removing one moves the last body into its slot,
+ * so the arrays stay dense while an id keeps naming the same body.
+ */
+class LevelBodies
+{
+public:
+    using Id = uint32_t;
+    static constexpr Id NoBody = UINT32_MAX;
+
+    enum Flag : uint8_t
+    {
+        // Standing in the level, not carried by another node
+        Free = 1 << 0,
+        Awake = 1 << 1,
+        // Skips its update while off screen
+        Culled = 1 << 2,
+        OnScreen = 1 << 3,
+        // Overlapping the player's collider
+        Touching = 1 << 4,
+    };
+
+private:
+    std::vector<olc::vf2d> positions;
+    std::vector<olc::vf2d> sizes;
+    std::vector<uint8_t> flags;
+    std::vector<NodeHandle> owners;
+    std::vector<Id> ids;
+    std::vector<uint32_t> slots;
+    std::vector<Id> freeIds;
+
+public:
+    Id add(NodeHandle owner, olc::vf2d position, olc::vf2d size, uint8_t flags)
+    {
+        Id id;
+
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<Id>(slots.size());
+            slots.push_back(0);
+        }
+
+        slots[id] = static_cast<uint32_t>(positions.size());
+        positions.push_back(position);
+        sizes.push_back(size);
+        this->flags.push_back(flags);
+        owners.push_back(owner);
+        ids.push_back(id);
+        return id;
+    }
+
+    void remove(Id id)
+    {
+        if (!isValid(id))
+            return;
+
+        uint32_t slot = slots[id];
+        uint32_t last = static_cast<uint32_t>(positions.size() - 1);
+
+        positions[slot] = positions[last];
+        sizes[slot] = sizes[last];
+        flags[slot] = flags[last];
+        owners[slot] = owners[last];
+        ids[slot] = ids[last];
+        slots[ids[slot]] = slot;
+
+        positions.pop_back();
+        sizes.pop_back();
+        flags.pop_back();
+        owners.pop_back();
+        ids.pop_back();
+
+        slots[id] = NoBody;
+        freeIds.push_back(id);
+    }
+
+    void clear()
+    {
+        positions.clear();
+        sizes.clear();
+        flags.clear();
+        owners.clear();
+        ids.clear();
+        slots.clear();
+        freeIds.clear();
+    }
+
+    bool isValid(Id id) const
+    {
+        return id < slots.size() && slots[id] != NoBody;
+    }
+
+    size_t size() const
+    {
+        return positions.size();
+    }
+
+    void place(Id id, olc::vf2d position)
+    {
+        if (isValid(id))
+            positions[slots[id]] = position;
+    }
+
+    void resize(Id id, olc::vf2d size)
+    {
+        if (isValid(id))
+            sizes[slots[id]] = size;
+    }
+
+    void set(Id id, Flag flag, bool value)
+    {
+        if (!isValid(id))
+            return;
+
+        auto &bits = flags[slots[id]];
+        bits = value ? (bits | flag) : (bits & ~flag);
+    }
+
+    bool is(Id id, Flag flag) const
+    {
+        return isValid(id) && (flags[slots[id]] & flag);
+    }
+
+    /**
+     * Whether the body's node is culled this frame: free, opted in and off
+     * screen as of the last logic phase.
+     */
+    bool isCulledOut(Id id) const
+    {
+        if (!isValid(id))
+            return false;
+
+        auto bits = flags[slots[id]];
+        return (bits & (Free | Culled | OnScreen)) == (Free | Culled);
+    }
+
+    olc::utils::geom2d::rect<float> getCollider(Id id) const
+    {
+        if (!isValid(id))
+            return {};
+
+        return {positions[slots[id]], sizes[slots[id]]};
+    }
+
+    void setAll(Flag flag)
+    {
+        for (auto &bits : flags)
+            bits |= flag;
+    }
+
+    /**
+     * The logic phase's walk. screen is the camera's view as
+     * Camera::IsOnScreen sees it, which tests a 16x16 box at the position.
+     */
+    void classify(const olc::utils::geom2d::rect<float> &screen, const olc::utils::geom2d::rect<float> *player)
+    {
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            uint8_t bits = flags[i] & ~(OnScreen | Touching);
+
+            if (overlaps(screen, olc::utils::geom2d::rect<float>(positions[i], {16, 16})))
+                bits |= OnScreen;
+
+            if (player != nullptr && overlaps(olc::utils::geom2d::rect<float>(positions[i], sizes[i]), *player))
+                bits |= Touching;
+
+            flags[i] = bits;
+        }
+    }
+
+    /**
+     * Hands every awake free body standing outside area to onSleep with its
+     * owner and position. The ones it returns true for are marked asleep.
+     */
+    template <typename F>
+    void sleepOutside(const olc::utils::geom2d::rect<float> &area, F &&onSleep)
+    {
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            if ((flags[i] & (Free | Awake)) != (Free | Awake) || contains(area, positions[i]))
+                continue;
+
+            if (onSleep(owners[i], positions[i]))
+                flags[i] &= ~Awake;
+        }
+    }
+};
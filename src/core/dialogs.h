@@ -0,0 +1,205 @@
+#pragma once
+
+#include <fstream>
+
+/**
+ * Every dialog message, declared once. The text lives in assets/dialogs.txt
+ * under the same name, so a dialog only carries its message's index.
+ */
+#define GAME_MESSAGES(MESSAGE)      \
+    MESSAGE(Credits)                \
+    MESSAGE(CollectHint)            \
+    MESSAGE(StorageFull)            \
+    MESSAGE(PurseCollected)         \
+    MESSAGE(BugSprayHint)           \
+    MESSAGE(GemSorry)               \
+    MESSAGE(GemThanks)              \
+    MESSAGE(ShellGamePick)          \
+    MESSAGE(ShellGameKeys)          \
+    MESSAGE(AndersonHello)          \
+    MESSAGE(AndersonAsksFlower)     \
+    MESSAGE(YouFlowerIsPurple)      \
+    MESSAGE(AndersonAsksAgain)      \
+    MESSAGE(YouGoAhead)             \
+    MESSAGE(AndersonFeelsWeird)     \
+    MESSAGE(AndersonTurning)        \
+    MESSAGE(ActOneVillain)          \
+    MESSAGE(AndersonIsVillain)      \
+    MESSAGE(ErikHello)              \
+    MESSAGE(ErikAsksHelp)           \
+    MESSAGE(ErikPromisesSecret)     \
+    MESSAGE(YouWillHelp)            \
+    MESSAGE(ErikGoSaveTheWorld)     \
+    MESSAGE(ErikThanks)             \
+    MESSAGE(ErikIsABee)             \
+    MESSAGE(ErikJustKidding)        \
+    MESSAGE(ErikTheSecretIs)        \
+    MESSAGE(ErikOpensPortals)       \
+    MESSAGE(ErikPortalToCity)       \
+    MESSAGE(ErikHexGuardian)        \
+    MESSAGE(ErikInfinityGem)        \
+    MESSAGE(MartinThinking)         \
+    MESSAGE(MartinThinkingOne)      \
+    MESSAGE(MartinThinkingTwo)      \
+    MESSAGE(MartinHello)            \
+    MESSAGE(MartinProtectsGem)      \
+    MESSAGE(MartinKnowsThoughts)    \
+    MESSAGE(MartinAndYes)           \
+    MESSAGE(MartinGoldArmor)        \
+    MESSAGE(YouWasNotThinking)      \
+    MESSAGE(MartinMessingWithYou)   \
+    MESSAGE(YouLooksLikePlastic)    \
+    MESSAGE(MartinNoPlasticYet)     \
+    MESSAGE(MartinCantHaveGem)      \
+    MESSAGE(MartinProveYourself)    \
+    MESSAGE(MartinShellGame)        \
+    MESSAGE(MartinGuessTheGem)      \
+    MESSAGE(YouSoundsFair)          \
+    MESSAGE(MartinAnotherChance)    \
+    MESSAGE(MartinYouWon)           \
+    MESSAGE(MartinUseItWisely)      \
+    MESSAGE(MartinYouLost)
+
+enum class MessageId : uint16_t
+{
+#define DECLARE_MESSAGE(NAME) NAME,
+    GAME_MESSAGES(DECLARE_MESSAGE)
+#undef DECLARE_MESSAGE
+        Count,
+};
+
+constexpr std::string_view MessageNames[] = {
+#define DECLARE_MESSAGE_NAME(NAME) #NAME,
+    GAME_MESSAGES(DECLARE_MESSAGE_NAME)
+#undef DECLARE_MESSAGE_NAME
+};
+
+constexpr uint32_t MessageKeys[] = {
+#define DECLARE_MESSAGE_KEY(NAME) HashKey(#NAME),
+    GAME_MESSAGES(DECLARE_MESSAGE_KEY)
+#undef DECLARE_MESSAGE_KEY
+};
+
+/**
+ * Looks a message up by name. Returns MessageId::Count for unknown names.
+ */
+constexpr MessageId FindMessage(std::string_view name)
+{
+    auto key = HashKey(name);
+
+    for (size_t i = 0; i < static_cast<size_t>(MessageId::Count); i++)
+        if (MessageKeys[i] == key && MessageNames[i] == name)
+            return static_cast<MessageId>(i);
+
+    return MessageId::Count;
+}
+
+/**
+ * Resolves a message literal while compiling, a misspelled name doesn't build:
+ *
+ *     game->addDialog({Message("CollectHint"), 3.0f});
+ */
+consteval MessageId Message(std::string_view name)
+{
+    auto message = FindMessage(name);
+
+    if (message == MessageId::Count)
+        throw "Unknown dialog message";
+
+    return message;
+}
+
+/**
+ * @brief DialogTable
+ * The text of every message, loaded once at startup and only read after
+ * that, so every world can share one table. Each entry also keeps its size
+ * on screen, measured while loading.
+ *
+ * The file holds one message per line as `Name = text`, with `\n` for line
+ * breaks. Blank lines and lines starting with # are skipped.
+ */
+class DialogTable
+{
+private:
+    struct Entry
+    {
+        std::string text;
+        olc::vi2d size = {0, 0};
+    };
+
+    std::array<Entry, static_cast<size_t>(MessageId::Count)> entries;
+
+public:
+    void load(const std::string &path)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+            entries[i].text = MessageNames[i];
+
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cerr << "Could not read dialogs from '" << path << "'" << std::endl;
+            return;
+        }
+
+        std::array<bool, static_cast<size_t>(MessageId::Count)> loaded = {};
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            auto separator = line.find(" = ");
+            if (line.empty() || line[0] == '#' || separator == std::string::npos)
+                continue;
+
+            auto message = FindMessage(std::string_view(line).substr(0, separator));
+            if (message == MessageId::Count)
+            {
+                std::cerr << "Unknown dialog message '" << line.substr(0, separator) << "'" << std::endl;
+                continue;
+            }
+
+            auto index = static_cast<size_t>(message);
+            entries[index].text = unescape(std::string_view(line).substr(separator + 3));
+            loaded[index] = true;
+        }
+
+        // Shown by name, so a missing line is easy to spot in game
+        for (size_t i = 0; i < entries.size(); i++)
+            if (!loaded[i])
+                std::cerr << "No text for dialog message '" << MessageNames[i] << "'" << std::endl;
+
+        for (auto &entry : entries)
+            entry.size = MeasureText(entry.text);
+    }
+
+    const std::string &getText(MessageId message) const
+    {
+        return entries[static_cast<size_t>(message)].text;
+    }
+
+    olc::vi2d getSize(MessageId message) const
+    {
+        return entries[static_cast<size_t>(message)].size;
+    }
+
+private:
+    static std::string unescape(std::string_view text)
+    {
+        std::string output;
+        output.reserve(text.size());
+
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] == 'n')
+            {
+                output += '\n';
+                i++;
+                continue;
+            }
+
+            output += text[i];
+        }
+
+        return output;
+    }
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <bitset>
+#include <string_view>
+
+/**
+ * FNV-1a, usable at compile time so string keys can be resolved while
+ * compiling. A different seed gives an independent hash, which is how
+ * perfect hash tables search for a collision-free one.
+ */
+constexpr uint32_t HashKey(std::string_view key, uint32_t seed = 2166136261u)
+{
+    uint32_t hash = seed;
+
+    for (char c : key)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Every game flag, declared once. Adding one here is all it takes to use it.
+ */
+#define GAME_FLAGS(FLAG)                     \
+    FLAG(KnowsHowToCollect)                  \
+    FLAG(KnowsHowToUseBugSpray)              \
+    FLAG(DidTeachHowToPlayShellGame)         \
+    FLAG(showGem)                            \
+    FLAG(level_portal)
+
+enum class GameFlag : uint8_t
+{
+#define DECLARE_FLAG(NAME) NAME,
+    GAME_FLAGS(DECLARE_FLAG)
+#undef DECLARE_FLAG
+        Count,
+};
+
+constexpr std::string_view GameFlagNames[] = {
+#define DECLARE_FLAG_NAME(NAME) #NAME,
+    GAME_FLAGS(DECLARE_FLAG_NAME)
+#undef DECLARE_FLAG_NAME
+};
+
+constexpr uint32_t GameFlagKeys[] = {
+#define DECLARE_FLAG_KEY(NAME) HashKey(#NAME),
+    GAME_FLAGS(DECLARE_FLAG_KEY)
+#undef DECLARE_FLAG_KEY
+};
+
+constexpr bool HasUniqueFlagKeys()
+{
+    constexpr size_t count = static_cast<size_t>(GameFlag::Count);
+
+    for (size_t i = 0; i < count; i++)
+        for (size_t j = i + 1; j < count; j++)
+            if (GameFlagKeys[i] == GameFlagKeys[j])
+                return false;
+
+    return true;
+}
+
+static_assert(HasUniqueFlagKeys(), "Two game flags hash to the same key");
+
+/**
+ * Looks a flag up by name. Returns GameFlag::Count for unknown names.
+ */
+constexpr GameFlag FindFlag(std::string_view name)
+{
+    auto key = HashKey(name);
+
+    for (size_t i = 0; i < static_cast<size_t>(GameFlag::Count); i++)
+        if (GameFlagKeys[i] == key && GameFlagNames[i] == name)
+            return static_cast<GameFlag>(i);
+
+    return GameFlag::Count;
+}
+
+/**
+ * Resolves a flag literal while compiling, a misspelled name doesn't build:
+ *
+ *     game->getFlag(Flag("KnowsHowToCollect"));
+ */
+consteval GameFlag Flag(std::string_view name)
+{
+    auto flag = FindFlag(name);
+
+    if (flag == GameFlag::Count)
+        throw "Unknown game flag";
+
+    return flag;
+}
+
+/**
+ * @brief GameFlags
+ * One bit per declared flag, checking one is a single bit test.
+ */
+class GameFlags
+{
+private:
+    std::bitset<static_cast<size_t>(GameFlag::Count)> bits;
+
+public:
+    bool get(GameFlag flag) const
+    {
+        return bits.test(static_cast<size_t>(flag));
+    }
+
+    bool set(GameFlag flag, bool value)
+    {
+        bits.set(static_cast<size_t>(flag), value);
+        return value;
+    }
+
+    void clear()
+    {
+        bits.reset();
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+class CoreNode;
+
+/**
+ * @brief NodeHandle
+ * Weak reference to a node: a slot index plus the generation the slot had
+ * when the handle was issued. Once the node is released the slot's
+ * generation moves on and every old handle resolves to nullptr.
+ */
+struct NodeHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool isNull() const
+    {
+        return generation == 0;
+    }
+
+    bool operator==(const NodeHandle &other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const NodeHandle &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+class NodeHandleTable
+{
+private:
+    struct Slot
+    {
+        CoreNode *node = nullptr;
+        uint32_t generation = 1;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+public:
+    /**
+     * One table per thread, so worlds simulated on different threads never
+     * share one. A world has to stay on the thread it was created on.
+     */
+    static NodeHandleTable &get()
+    {
+        static thread_local NodeHandleTable instance;
+        return instance;
+    }
+
+    NodeHandle acquire(CoreNode *node)
+    {
+        uint32_t index;
+
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        slots[index].node = node;
+        return {index, slots[index].generation};
+    }
+
+    /**
+     * Invalidates every copy of the handle. Releasing a stale handle is a no-op.
+     */
+    void release(NodeHandle handle)
+    {
+        if (resolve(handle) == nullptr)
+            return;
+
+        auto &slot = slots[handle.index];
+        slot.node = nullptr;
+
+        // Generation 0 is reserved for null handles
+        if (++slot.generation == 0)
+            slot.generation = 1;
+
+        freeSlots.push_back(handle.index);
+    }
+
+    CoreNode *resolve(NodeHandle handle) const
+    {
+        if (handle.isNull() || handle.index >= slots.size())
+            return nullptr;
+
+        auto &slot = slots[handle.index];
+        return slot.generation == handle.generation ? slot.node : nullptr;
+    }
+};
+
+/**
+ * @brief NodeRef
+ * Typed wrapper around a NodeHandle for nodes that cache other nodes.
+ */
+template <typename T>
+class NodeRef
+{
+private:
+    NodeHandle handle;
+
+public:
+    NodeRef() = default;
+
+    NodeRef(T *node)
+    {
+        *this = node;
+    }
+
+    NodeRef &operator=(T *node)
+    {
+        handle = node ? node->getHandle() : NodeHandle();
+        return *this;
+    }
+
+    T *get() const
+    {
+        return static_cast<T *>(NodeHandleTable::get().resolve(handle));
+    }
+
+    NodeHandle getHandle() const
+    {
+        return handle;
+    }
+};
@@ -44,12 +44,20 @@ struct Camera
     }
 
     bool IsOnScreen(olc::vf2d pos)
+    {
+        rect<float> objectRect = rect<float>(pos, {16, 16});
+        return overlaps(GetScreenRect(), objectRect);
+    }
+
+    /**
+     * What IsOnScreen tests positions against, for loops testing many.
+     */
+    rect<float> GetScreenRect()
     {
         auto position = GetPosition();
         olc::vf2d screenSize = {SCREEN_WIDTH, SCREEN_HEIGHT};
 
         rect<float> cameraRect = rect<float>({position, screenSize});
-        rect<float> objectRect = rect<float>(pos, {16, 16});
 
         // add some padding to the camera
         cameraRect.pos.x -= 40;
@@ -61,13 +69,17 @@ struct Camera
         cameraRect.pos.x -= offset.x;
         cameraRect.pos.y -= offset.y;
 
-        return overlaps(cameraRect, objectRect);
+        return cameraRect;
     }
 
-    bool IsOnScreen(const ldtk::IntPoint &point)
+    /**
+     * The part of the world on screen, grown by margin on every side.
+     */
+    rect<float> GetViewRect(float margin = 0.0f)
     {
-        olc::vf2d pos = {static_cast<float>(point.x), static_cast<float>(point.y)};
-        return IsOnScreen(pos);
+        olc::vf2d screenSize = {SCREEN_WIDTH, SCREEN_HEIGHT};
+        olc::vf2d pos = GetPosition() - offset - olc::vf2d{margin, margin};
+        return rect<float>(pos, screenSize / zoom + olc::vf2d{margin, margin} * 2.0f);
     }
 
     olc::vf2d GetPosition()
@@ -96,24 +108,214 @@ struct Camera
 
 #pragma endregion Camera
 
+#pragma region Node Types
+
+using NameId = uint32_t;
+
+/**
+ * Interns node names into small ids. Id 0 is reserved for the empty name.
+ * Hot code should intern its names once and look children up by id.
+ */
+struct NodeNames
+{
+    static NameId intern(const std::string &name)
+    {
+        if (name.empty())
+            return 0;
+
+        auto &ids = table();
+        auto [it, inserted] = ids.try_emplace(name, static_cast<NameId>(ids.size() + 1));
+        return it->second;
+    }
+
+    static NameId find(const std::string &name)
+    {
+        auto &ids = table();
+        auto it = ids.find(name);
+        return it != ids.end() ? it->second : 0;
+    }
+
+private:
+    static std::unordered_map<std::string, NameId> &table()
+    {
+        // Per thread like the handle table, ids only mean something within one
+        static thread_local std::unordered_map<std::string, NameId> ids;
+        return ids;
+    }
+};
+
+#pragma endregion Node Types
+
+#pragma region Input
+
+enum class InputAction : uint8_t
+{
+    Up,
+    Down,
+    Left,
+    Right,
+    Enter,
+    Count,
+};
+
+/**
+ * Delivery order of an action, lowest first. A listener that consumes an
+ * action stops it from reaching the ones after it.
+ */
+namespace InputPriority
+{
+    constexpr int Dialog = 0;
+    constexpr int Player = 10;
+    constexpr int NPC = 20;
+    constexpr int Item = 30;
+}
+
+#pragma endregion Input
+
 #pragma region CoreNode
 
 class CoreNode
 {
 public:
-    std::string name;
+    // Hot: what the per-frame loops read of every node, declared first so it
+    // sits next to the vtable pointer
     olc::vf2d position;
     GameNode *game = nullptr;
-    CoreNode *parent = nullptr;
-    std::vector<CoreNode *> children;
+
+protected:
+    // Where the level keeps the node's per-frame state, if it does
+    LevelBodies::Id body = LevelBodies::NoBody;
+
+private:
+    friend class GameNode;
+
+    NodeHandle handle;
+    NodeHandle parent;
+    NodeTypeId typeId = 0;
+    bool destroyed = false;
+    bool sleeping = false;
+    bool sleepable = false;
+
+public:
+    // Cold: naming, the tree and what the UI shows, read on lookups and events
+    std::string name;
+    NameId nameId = 0;
+    SmallVector<CoreNode *, 4> children;
     AssetOptions *thumbnail = nullptr;
 
-    CoreNode(const std::string &name, GameNode *game) : name(name), position({0, 0}), game(game)
+    /**
+     * Whether nodes of the class may be put to sleep far from the camera,
+     * declared per class like Streamed and read by declareType.
+     */
+    static constexpr bool Sleeps = false;
+
+    CoreNode(const std::string &name, GameNode *game) : position({0, 0}), game(game), name(name), nameId(NodeNames::intern(name))
+    {
+        declareType<CoreNode>();
+        handle = NodeHandleTable::get().acquire(this);
+    }
+
+    NodeHandle getHandle() const
+    {
+        return handle;
+    }
+
+    /**
+     * Whether the node was released and is only waiting to be freed.
+     */
+    bool isReleased() const
+    {
+        return NodeHandleTable::get().resolve(handle) != this;
+    }
+
+    /**
+     * Whether the node is released or queued to be destroyed.
+     */
+    bool isDestroyed() const
+    {
+        return destroyed || isReleased();
+    }
+
+    /**
+     * Bumped by every change to any node's children, so cached views of the
+     * tree can tell they are out of date.
+     */
+    static uint32_t getStructureVersion()
+    {
+        return structureVersion();
+    }
+
+    /**
+     * Whether the game put the node to sleep for being far from the camera.
+     * Sleeping nodes aren't updated.
+     */
+    bool isSleeping() const
+    {
+        return sleeping;
+    }
+
+    /**
+     * Whether the node's class may be put to sleep at all, its Sleeps.
+     */
+    bool isSleepable() const
+    {
+        return sleepable;
+    }
+
+    /**
+     * Invalidates every handle to this node and its subtree.
+     */
+    void release()
+    {
+        NodeHandleTable::get().release(handle);
+
+        for (auto *child : children)
+            child->release();
+    }
+
+    /**
+     * Gives a released node and its subtree new handles, for nodes that are
+     * reused instead of reallocated. Handles from before stay stale.
+     */
+    void renew()
+    {
+        NodeHandleTable::get().release(handle);
+        handle = NodeHandleTable::get().acquire(this);
+
+        for (auto *child : children)
+            child->renew();
+    }
+
+    CoreNode *getParent() const
+    {
+        return NodeHandleTable::get().resolve(parent);
+    }
+
+    void setParent(CoreNode *node)
+    {
+        parent = node ? node->handle : NodeHandle();
+    }
+
+    /**
+     * Renames the node, keeping the parent's name index in sync.
+     */
+    void setName(const std::string &name)
     {
+        auto *parent = getParent();
+
+        if (parent)
+            parent->unindexChild(this);
+
+        this->name = name;
+        nameId = NodeNames::intern(name);
+
+        if (parent)
+            parent->indexChild(this);
     }
 
     virtual ~CoreNode()
     {
+        NodeHandleTable::get().release(handle);
     }
 
     bool empty() const
@@ -121,6 +323,11 @@ public:
         return children.empty();
     }
 
+    /**
+     * The context of the world the node belongs to.
+     */
+    virtual GameContext &getContext();
+
     virtual rect<float> getCollider()
     {
         return rect<float>(position, {SPRITE_SIZE, SPRITE_SIZE});
@@ -133,6 +340,8 @@ public:
             return false;
 
         children.push_back(node);
+        indexChild(node);
+        structureChanged();
         return true;
     }
 
@@ -147,12 +356,20 @@ public:
             return false;
 
         children.insert(children.begin(), node);
+        indexChild(node, true);
+        structureChanged();
         return true;
     }
 
     void removeChild(CoreNode *node)
     {
-        children.erase(std::remove(children.begin(), children.end(), node), children.end());
+        auto it = std::remove(children.begin(), children.end(), node);
+        if (it == children.end())
+            return;
+
+        children.erase(it, children.end());
+        unindexChild(node);
+        structureChanged();
     }
 
     void moveChildrenToRoot(CoreNode *root)
@@ -162,10 +379,10 @@ public:
 
     void moveChildToRoot(CoreNode *child, CoreNode *root)
     {
-        if (child->parent != this)
+        if (child->getParent() != this)
             return;
 
-        child->parent = nullptr;
+        child->setParent(nullptr);
         root->addChild(child);
         child->onReparent();
         removeChild(child);
@@ -174,29 +391,80 @@ public:
     void clearChildren()
     {
         children.clear();
+        structureChanged();
+
+        for (auto &bucket : childrenByType)
+            bucket.clear();
+
+        for (auto &[id, named] : childrenByName)
+            named.clear();
     }
 
     void reparent(CoreNode *newParent)
     {
-        if (parent)
+        if (auto *parent = getParent())
             parent->removeChild(this);
 
-        parent = newParent;
+        setParent(newParent);
         newParent->addChild(this);
     }
 
+    /**
+     * Id of the most derived class, the last one to declare itself.
+     */
+    NodeTypeId getTypeId() const
+    {
+        return typeId;
+    }
+
     template <typename T>
-    T *getChildOfType(std::string name = "")
+    bool isOfType() const
     {
-        for (auto &child : children)
+        return std::find(types.begin(), types.end(), NodeTypes::of<T>()) != types.end();
+    }
+
+    /**
+     * Children that are a T (or derive from it), in child order.
+     */
+    template <typename T>
+    const std::vector<CoreNode *> &getChildrenOfType() const
+    {
+        static const std::vector<CoreNode *> none;
+        auto type = NodeTypes::of<T>();
+        return type < childrenByType.size() ? childrenByType[type] : none;
+    }
+
+    template <typename T>
+    T *getChildOfType(const std::string &name = "")
+    {
+        if (name.empty())
+            return getChildOfType<T>(NameId(0));
+
+        // A name that was never interned can't belong to any child
+        auto id = NodeNames::find(name);
+        return id ? getChildOfType<T>(id) : nullptr;
+    }
+
+    /**
+     * First child that is a T and, unless name is 0, has that interned name.
+     */
+    template <typename T>
+    T *getChildOfType(NameId name)
+    {
+        if (name == 0)
         {
-            if (!name.empty() && child->name != name)
-                continue;
-            auto casted = dynamic_cast<T *>(child);
-            if (casted != nullptr)
-                return casted;
+            auto &matches = getChildrenOfType<T>();
+            return matches.empty() ? nullptr : static_cast<T *>(matches.front());
         }
 
+        auto it = childrenByName.find(name);
+        if (it == childrenByName.end())
+            return nullptr;
+
+        for (auto *child : it->second)
+            if (child->isOfType<T>())
+                return static_cast<T *>(child);
+
         return nullptr;
     }
 
@@ -211,7 +479,7 @@ public:
 
     virtual void onUpdated(float fElapsedTime)
     {
-        if (parent != nullptr)
+        if (auto *parent = getParent())
             position = parent->position;
 
         for (auto child : children)
@@ -221,14 +489,12 @@ public:
     template <typename T>
     int getFirstIndexOfType()
     {
-        for (int i = 0; i < children.size(); i++)
-        {
-            auto casted = dynamic_cast<T *>(children[i]);
-            if (casted != nullptr)
-                return i;
-        }
+        auto &matches = getChildrenOfType<T>();
+        if (matches.empty())
+            return -1;
 
-        return -1;
+        auto it = std::find(children.begin(), children.end(), matches.front());
+        return it - children.begin();
     }
 
     virtual void onUp()
@@ -255,12 +521,155 @@ public:
     {
     }
 
+    /**
+     * Called before a streamed node goes back to its pool for being far from
+     * the camera. The returned byte is all that is kept of it.
+     */
+    virtual uint8_t onStreamOut()
+    {
+        return 0;
+    }
+
+    /**
+     * Called after onCreated when a streamed node comes back, with the byte
+     * onStreamOut returned last time.
+     */
+    virtual void onStreamIn([[maybe_unused]] uint8_t state)
+    {
+    }
+
+    /**
+     * Writes what a world snapshot keeps of the node. Overrides write their
+     * base class first, onRestore reads it back in the same order.
+     */
+    virtual void onSnapshot(SnapshotWriter &writer) const
+    {
+        writer.write(position);
+    }
+
+    virtual void onRestore(SnapshotReader &reader)
+    {
+        reader.read(position);
+    }
+
+    /**
+     * Writes what a save file keeps of the node, one explicit field at a
+     * time. Most nodes keep nothing: a loaded level spawns them afresh.
+     */
+    virtual void onSaveGame([[maybe_unused]] SaveDataWriter &writer) const
+    {
+    }
+
+    virtual void onLoadGame([[maybe_unused]] SaveDataReader &reader)
+    {
+    }
+
+    /**
+     * Called by the InputDispatcher for actions the node subscribed to.
+     * Returns whether the action was consumed.
+     */
+    virtual bool onInput(InputAction action)
+    {
+        switch (action)
+        {
+        case InputAction::Up:
+            onUp();
+            break;
+        case InputAction::Down:
+            onDown();
+            break;
+        case InputAction::Left:
+            onLeft();
+            break;
+        case InputAction::Right:
+            onRight();
+            break;
+        case InputAction::Enter:
+            onEnter();
+            break;
+        default:
+            break;
+        }
+
+        return false;
+    }
+
+protected:
+    /**
+     * Every node class calls this from its constructor with its own type so
+     * the parent's type index can find it by any class in its hierarchy.
+     */
+    template <typename T>
+    void declareType()
+    {
+        types.push_back(NodeTypes::of<T>());
+        typeId = NodeTypes::of<T>();
+        sleepable = T::Sleeps;
+    }
+
 private:
+    int32_t spawnIndex = -1;
+    SmallVector<NodeTypeId, 6> types;
+    std::vector<std::vector<CoreNode *>> childrenByType;
+    std::unordered_map<NameId, std::vector<CoreNode *>> childrenByName;
+
+    // Per thread like the handle table, a world's nodes never leave its thread
+    static uint32_t &structureVersion()
+    {
+        static thread_local uint32_t version = 0;
+        return version;
+    }
+
+    static void structureChanged()
+    {
+        structureVersion()++;
+    }
+
+    void indexChild(CoreNode *node, bool front = false)
+    {
+        if (node->nameId != 0)
+        {
+            auto &named = childrenByName[node->nameId];
+            if (front)
+                named.insert(named.begin(), node);
+            else
+                named.push_back(node);
+        }
+
+        for (auto type : node->types)
+        {
+            if (type >= childrenByType.size())
+                childrenByType.resize(type + 1);
+
+            auto &bucket = childrenByType[type];
+            if (front)
+                bucket.insert(bucket.begin(), node);
+            else
+                bucket.push_back(node);
+        }
+    }
+
+    void unindexChild(CoreNode *node)
+    {
+        auto named = childrenByName.find(node->nameId);
+        if (named != childrenByName.end())
+            named->second.erase(std::remove(named->second.begin(), named->second.end(), node), named->second.end());
+
+        for (auto type : node->types)
+        {
+            if (type >= childrenByType.size())
+                continue;
+
+            auto &bucket = childrenByType[type];
+            bucket.erase(std::remove(bucket.begin(), bucket.end(), node), bucket.end());
+        }
+    }
+
     void reparentChildren(CoreNode *newParent, bool clearParent = false)
     {
         for (auto child : children)
         {
-            child->parent = clearParent ? nullptr : newParent;
+            child->setParent(clearParent ? nullptr : newParent);
             newParent->prependChild(child);
             child->onReparent();
         }
@@ -269,6 +678,31 @@ private:
     }
 };
 
+template <typename T, typename... Ts>
+bool HasDeclaredTypes(const CoreNode &node, TypeList<Ts...>)
+{
+    return node.getTypeId() == NodeTypes::of<T>() && ((!std::is_base_of_v<Ts, T> || node.isOfType<Ts>()) && ...);
+}
+
+/**
+ * Catches a node class that forgot declareType<T>() in its constructor,
+ * which would otherwise drop it out of typed child lookups without a word.
+ * Called wherever nodes are constructed; debug builds stop right there.
+ */
+template <typename T>
+T *CheckNodeType(T *node)
+{
+#ifndef NDEBUG
+    if (!HasDeclaredTypes<T>(*node, NodeTypeList()))
+    {
+        std::cerr << "Node class '" << typeid(T).name() << "' or one of its bases doesn't call declareType in its constructor" << std::endl;
+        std::abort();
+    }
+#endif
+
+    return node;
+}
+
 #pragma endregion CoreNode
 
 #pragma region MiniGame
@@ -282,6 +716,7 @@ private:
 public:
     MiniGame(const std::string &name, GameNode *game) : CoreNode(name, game)
     {
+        declareType<MiniGame>();
     }
 
     void finishGame(bool won)
@@ -321,541 +756,2534 @@ public:
 
 #pragma endregion MiniGame
 
-#pragma region Iterator
+#pragma region Input Dispatcher
 
-class CoreNodeIterator
+/**
+ * @brief InputDispatcher
+ * Delivers input actions to the nodes that subscribed to them, in priority
+ * order. Listeners are held by handle, so destroyed nodes drop out on their
+ * own and are pruned lazily.
+ */
+class InputDispatcher
 {
 private:
-    std::stack<CoreNode *> nodes;
+    struct Listener
+    {
+        int priority;
+        NodeHandle node;
+    };
+
+    std::array<std::vector<Listener>, static_cast<size_t>(InputAction::Count)> listeners;
 
 public:
-    CoreNodeIterator(CoreNode *root)
+    void subscribe(InputAction action, CoreNode *node, int priority)
     {
-        if (root)
-            nodes.push(root);
+        auto &list = listeners[static_cast<size_t>(action)];
+        auto handle = node->getHandle();
+
+        for (auto &listener : list)
+            if (listener.node == handle)
+                return;
+
+        // After every listener of the same priority, so ties keep subscription order
+        auto it = std::upper_bound(list.begin(), list.end(), priority, [](int priority, const Listener &listener)
+                                   { return priority < listener.priority; });
+        list.insert(it, {priority, handle});
     }
 
-    bool hasNext()
+    void unsubscribe(InputAction action, CoreNode *node)
     {
-        return !nodes.empty();
+        auto &list = listeners[static_cast<size_t>(action)];
+        auto handle = node->getHandle();
+        list.erase(std::remove_if(list.begin(), list.end(), [&](const Listener &listener)
+                                  { return listener.node == handle; }),
+                   list.end());
     }
 
-    CoreNode *next()
+    void dispatch(InputAction action)
     {
-        if (nodes.empty())
-            return nullptr;
-
-        CoreNode *current = nodes.top();
-        nodes.pop();
+        auto &list = listeners[static_cast<size_t>(action)];
+        auto &table = NodeHandleTable::get();
+        bool hasStale = false;
 
-        for (auto it = current->children.rbegin(); it != current->children.rend(); ++it)
+        // Index loop, a listener may subscribe others while handling the action
+        for (size_t i = 0; i < list.size(); i++)
         {
-            if (*it)
-                nodes.push(*it);
+            auto *node = table.resolve(list[i].node);
+
+            if (node == nullptr)
+            {
+                hasStale = true;
+                continue;
+            }
+
+            if (node->isDestroyed())
+                continue;
+
+            if (node->onInput(action))
+                break;
         }
 
-        return current;
+        if (hasStale)
+            prune(list);
     }
-};
 
-enum class HAlign
-{
-    Center,
-    Left,
-    Right,
-};
+    /**
+     * Drops listeners whose nodes were released.
+     */
+    void prune()
+    {
+        for (auto &list : listeners)
+            prune(list);
+    }
 
-enum class VAlign
-{
-    Center,
-    Top,
-    Bottom,
+private:
+    void prune(std::vector<Listener> &list)
+    {
+        auto &table = NodeHandleTable::get();
+        list.erase(std::remove_if(list.begin(), list.end(), [&](const Listener &listener)
+                                  { return table.resolve(listener.node) == nullptr; }),
+                   list.end());
+    }
 };
 
-#pragma endregion Iterator
-
-#pragma region GameNode
+#pragma endregion Input Dispatcher
 
-CoreNode *CreateNode(GameNode *node, const ldtk::Entity &entity);
-MiniGame *CreateMiniGame(const std::string &name, GameNode *node);
+#pragma region Phase Scheduler
 
-struct Dialog
+/**
+ * The steps of a frame, run in this order. Render is last and also covers
+ * nodes that still do everything in onUpdated.
+ */
+enum class UpdatePhase : uint8_t
 {
-    std::string message;
-    float duration = 1.0f;
-    bool fullscreen = false;
-    bool persistent = false;
-    uint8_t id = 0;
+    Input,
+    Physics,
+    Logic,
+    Animation,
+    Render,
+    Count,
 };
 
-class GameNode : public CoreNode
-{
+constexpr const char *UpdatePhaseNames[] = {"input", "physics", "logic", "animation", "render"};
 
+/**
+ * @brief PhaseScheduler
+ * Per-phase lists of node callbacks. Nodes register the member functions
+ * that make up their update and each phase runs its list in one loop, so a
+ * phase can be timed or switched off on its own. Nodes are held by handle
+ * and skipped while destroyed or asleep.
+ */
+class PhaseScheduler
+{
 private:
-    std::string selectedLevel = "level_1";
-    ldtk::Project project;
-    GameImageAssetProvider *backgroundProvider = nullptr;
-    std::vector<olc::utils::geom2d::rect<float> *> colliders;
-    std::vector<olc::utils::geom2d::rect<float> *> onScreenColliders;
-    std::vector<Dialog> dialogs;
-    std::map<std::string, bool> flags;
-    Sound *deadSound = nullptr;
-    CoreNode *playerNode = nullptr;
-    MiniGame *currentMiniGame = nullptr;
-    bool displayingMinigame = false;
-    bool didLoadMusic = false;
+    using Callback = void (*)(CoreNode *, float);
 
-public:
-    bool isGameOver = false;
-    Camera camera;
-    GameImageAssetProvider *spritesProvider = nullptr;
-    CoreNode *uiNode = nullptr;
+    struct Participant
+    {
+        NodeHandle node;
+        Callback callback;
+    };
+
+    static constexpr size_t PhaseCount = static_cast<size_t>(UpdatePhase::Count);
 
-    GameNode(CoreNode *uiNode) : CoreNode("Game", nullptr)
+    std::array<std::vector<Participant>, PhaseCount> participants;
+    std::array<bool, PhaseCount> enabled;
+    std::array<float, PhaseCount> milliseconds = {};
+
+public:
+    PhaseScheduler()
     {
-        onScreenColliders.reserve(100);
-        dialogs.reserve(10);
-        this->uiNode = uiNode;
+        enabled.fill(true);
     }
 
-    const ldtk::Enum &getGameEnum(const std::string &name)
+    /**
+     * Registers node's Method to run every frame during phase:
+     *
+     *     scheduler.add<&PlayerNode::stepPhysics>(UpdatePhase::Physics, this);
+     */
+    template <auto Method, typename T>
+    void add(UpdatePhase phase, T *node)
     {
-        return project.getWorld().getEnum(name);
+        Callback callback = [](CoreNode *node, float fElapsedTime)
+        {
+            (static_cast<T *>(node)->*Method)(fElapsedTime);
+        };
+
+        participants[index(phase)].push_back({node->getHandle(), callback});
     }
 
-    olc::vf2d getPositionForEnumValue(const std::string &enumName, const std::string &value)
+    /**
+     * Runs one phase. Released nodes are dropped from the list as it goes.
+     */
+    template <typename F>
+    void run(UpdatePhase phase, float fElapsedTime, F &&extra)
     {
-        auto &enumValue = getGameEnum(enumName)[value];
-        auto &textureRect = enumValue.getIconTextureRect();
-        return {static_cast<float>(textureRect.x), static_cast<float>(textureRect.y)};
+        auto i = index(phase);
+        if (!enabled[i])
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+        auto &list = participants[i];
+
+        // Index loop, a callback may register more participants
+        for (size_t j = 0; j < list.size(); j++)
+        {
+            auto *node = NodeHandleTable::get().resolve(list[j].node);
+            if (node == nullptr || node->isDestroyed() || node->isSleeping())
+                continue;
+
+            list[j].callback(node, fElapsedTime);
+        }
+
+        extra(fElapsedTime);
+
+        std::erase_if(list, [](const Participant &participant)
+                      { return NodeHandleTable::get().resolve(participant.node) == nullptr; });
+
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        milliseconds[i] = elapsed.count();
     }
 
-    void onCreated() override
+    void run(UpdatePhase phase, float fElapsedTime)
     {
-        CoreNode::onCreated();
-        selectedLevel = "level_1";
-        camera = Camera();
-        project.loadFromFile("assets/map_project/QuestForTrueColor.ldtk");
-        spritesProvider = new GameImageAssetProvider("assets/sprite_project/Sprites.png");
-        deadSound = new Sound("assets/sfx/game_over.wav", 1);
-        loadLevel(selectedLevel);
-        displayingMinigame = false;
-        addDialog({"Developed by Anderson, with love and coffee <3", 3.0f, true, false});
-        didLoadMusic = false;
+        run(phase, fElapsedTime, [](float) {});
     }
 
-    ~GameNode()
+    void setEnabled(UpdatePhase phase, bool value)
     {
-        delete spritesProvider;
-        delete deadSound;
-        delete backgroundProvider;
-        // ClearMusic();
+        enabled[index(phase)] = value;
+    }
+
+    bool isEnabled(UpdatePhase phase) const
+    {
+        return enabled[index(phase)];
+    }
+
+    /**
+     * How long the phase took the last time it ran.
+     */
+    float getMilliseconds(UpdatePhase phase) const
+    {
+        return milliseconds[index(phase)];
+    }
+
+private:
+    static size_t index(UpdatePhase phase)
+    {
+        return static_cast<size_t>(phase);
+    }
+};
+
+#pragma endregion Phase Scheduler
+
+#pragma region Timers
+
+/**
+ * Identifies a scheduled timer. Stale once the timer fired or was cancelled.
+ */
+struct TimerHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+};
+
+/**
+ * @brief TimerWheel
+ * Game clock plus every pending timer, kept in a hierarchical timing wheel:
+ * four levels of 64 slots, one millisecond per slot on the first level and
+ * 64 times coarser on each level up. Advancing the clock only touches the
+ * slots it passes, so timers that aren't due cost nothing per frame.
+ *
+ * Timers belong to a node and are dropped without firing if the node was
+ * released in the meantime. The clock runs at timeScale, 0 pauses it.
+ */
+class TimerWheel
+{
+private:
+    static constexpr uint64_t TicksPerSecond = 1000;
+    static constexpr int SlotBits = 6;
+    static constexpr uint64_t SlotCount = 1 << SlotBits;
+    static constexpr uint64_t SlotMask = SlotCount - 1;
+    static constexpr int Levels = 4;
+
+    struct Timer
+    {
+        uint64_t due = 0;
+        NodeHandle owner;
+        std::function<void()> callback;
+        uint32_t generation = 1;
+        bool pending = false;
+    };
+
+    std::vector<Timer> timers;
+    std::vector<uint32_t> freeTimers;
+    std::array<std::array<std::vector<TimerHandle>, SlotCount>, Levels> wheel;
+    std::vector<TimerHandle> firing;
+    uint64_t currentTick = 0;
+    double time = 0.0;
+    float timeScale = 1.0f;
+
+public:
+    /**
+     * Runs callback once, seconds of game time from now, if owner still exists.
+     */
+    TimerHandle after(float seconds, CoreNode *owner, std::function<void()> callback)
+    {
+        uint32_t index;
+
+        if (!freeTimers.empty())
+        {
+            index = freeTimers.back();
+            freeTimers.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(timers.size());
+            timers.emplace_back();
+        }
+
+        auto &timer = timers[index];
+        uint64_t delay = static_cast<uint64_t>(std::max(0.0f, seconds) * TicksPerSecond);
+        timer.due = currentTick + std::max<uint64_t>(delay, 1);
+        timer.owner = owner ? owner->getHandle() : NodeHandle();
+        timer.callback = std::move(callback);
+        timer.pending = true;
+
+        TimerHandle handle = {index, timer.generation};
+        insert(handle);
+        return handle;
+    }
+
+    /**
+     * Sets target to value after the delay, the common case of a timed state.
+     */
+    template <typename T>
+    TimerHandle setAfter(float seconds, CoreNode *owner, T &target, T value)
+    {
+        return after(seconds, owner, [&target, value]()
+                     { target = value; });
+    }
+
+    void cancel(TimerHandle handle)
+    {
+        if (isPending(handle))
+            retire(handle.index);
+    }
+
+    bool isPending(TimerHandle handle) const
+    {
+        return handle.index < timers.size() && timers[handle.index].pending && timers[handle.index].generation == handle.generation;
+    }
+
+    /**
+     * Seconds of game time until a pending timer fires, 0 once it is stale.
+     */
+    float remaining(TimerHandle handle) const
+    {
+        if (!isPending(handle))
+            return 0.0f;
+
+        uint64_t due = timers[handle.index].due;
+        return due > currentTick ? static_cast<float>(due - currentTick) / TicksPerSecond : 0.0f;
+    }
+
+    /**
+     * Moves the clock forward by fElapsedTime scaled by the time scale, firing
+     * every timer due on the way. Returns the scaled time so the frame can
+     * use the same step.
+     */
+    float advance(float fElapsedTime)
+    {
+        float scaled = fElapsedTime * timeScale;
+        time += scaled;
+
+        uint64_t targetTick = static_cast<uint64_t>(time * TicksPerSecond);
+        while (currentTick < targetTick)
+        {
+            currentTick++;
+
+            if ((currentTick & SlotMask) == 0)
+                cascade(1);
+
+            fire(wheel[0][currentTick & SlotMask]);
+        }
+
+        return scaled;
+    }
+
+    /**
+     * Seconds of game time since the clock was last cleared.
+     */
+    float now() const
+    {
+        return static_cast<float>(time);
+    }
+
+    void setTimeScale(float scale)
+    {
+        timeScale = std::max(0.0f, scale);
+    }
+
+    float getTimeScale() const
+    {
+        return timeScale;
+    }
+
+    /**
+     * Cancels every timer and rewinds the clock.
+     */
+    void clear()
+    {
+        for (uint32_t i = 0; i < timers.size(); i++)
+            if (timers[i].pending)
+                retire(i);
+
+        for (auto &level : wheel)
+            for (auto &slot : level)
+                slot.clear();
+
+        currentTick = 0;
+        time = 0.0;
+    }
+
+    /**
+     * Cancels every timer and sets the clock to seconds, for restoring a
+     * snapshot. Whoever owned the timers schedules them again.
+     */
+    void rewind(float seconds)
+    {
+        clear();
+        time = std::max(0.0f, seconds);
+        currentTick = static_cast<uint64_t>(time * TicksPerSecond);
+    }
+
+private:
+    void insert(TimerHandle handle)
+    {
+        uint64_t due = timers[handle.index].due;
+        uint64_t delta = due > currentTick ? due - currentTick : 0;
+
+        int level = 0;
+        while (level < Levels - 1 && delta >= (SlotCount << (level * SlotBits)))
+            level++;
+
+        // Past the last level the timer waits in the furthest slot and cascades down from there
+        uint64_t slotTick = std::min(due, currentTick + (SlotCount << (level * SlotBits)) - 1);
+        wheel[level][(slotTick >> (level * SlotBits)) & SlotMask].push_back(handle);
+    }
+
+    /**
+     * Pours the slot of level that the clock just reached into the levels
+     * below it, after doing the same for the level above if it wrapped too.
+     */
+    void cascade(int level)
+    {
+        if (level >= Levels)
+            return;
+
+        uint64_t slot = (currentTick >> (level * SlotBits)) & SlotMask;
+        if (slot == 0)
+            cascade(level + 1);
+
+        auto moving = std::move(wheel[level][slot]);
+        wheel[level][slot].clear();
+
+        for (auto handle : moving)
+            if (isPending(handle))
+                insert(handle);
+    }
+
+    void fire(std::vector<TimerHandle> &slot)
+    {
+        if (slot.empty())
+            return;
+
+        // Callbacks may schedule timers into this same slot
+        firing.swap(slot);
+
+        for (auto handle : firing)
+        {
+            if (!isPending(handle))
+                continue;
+
+            auto &timer = timers[handle.index];
+            if (timer.due > currentTick)
+            {
+                insert(handle);
+                continue;
+            }
+
+            auto callback = std::move(timer.callback);
+            auto owner = timer.owner;
+            retire(handle.index);
+
+            if (owner.isNull() || NodeHandleTable::get().resolve(owner) != nullptr)
+                callback();
+        }
+
+        firing.clear();
+    }
+
+    void retire(uint32_t index)
+    {
+        auto &timer = timers[index];
+        timer.pending = false;
+        timer.callback = nullptr;
+
+        if (++timer.generation == 0)
+            timer.generation = 1;
+
+        freeTimers.push_back(index);
+    }
+};
+
+#pragma endregion Timers
+
+#pragma region Quests
+
+/**
+ * Counters quests are tracked with. A counter is complete when it reaches 0.
+ */
+enum class QuestCounter : uint8_t
+{
+    MadBees,
+    Count,
+};
+
+/**
+ * @brief QuestLog
+ * Aggregate counters kept up to date by the events that change them, so a
+ * quest check is a lookup instead of a scan over the level. Nodes can ask
+ * to be told when a counter is done.
+ */
+class QuestLog
+{
+private:
+    struct Listener
+    {
+        QuestCounter counter;
+        NodeHandle owner;
+        std::function<void()> callback;
+    };
+
+    std::vector<Listener> listeners;
+
+public:
+    using Counters = std::array<int, static_cast<size_t>(QuestCounter::Count)>;
+
+private:
+    Counters counters = {};
+
+public:
+    /**
+     * Starts over, forgetting every counter and listener. Called on level load.
+     */
+    void reset()
+    {
+        counters.fill(0);
+        listeners.clear();
+    }
+
+    int get(QuestCounter counter) const
+    {
+        return counters[static_cast<size_t>(counter)];
+    }
+
+    bool isCompleted(QuestCounter counter) const
+    {
+        return get(counter) <= 0;
+    }
+
+    void set(QuestCounter counter, int value)
+    {
+        counters[static_cast<size_t>(counter)] = value;
+    }
+
+    const Counters &getCounters() const
+    {
+        return counters;
+    }
+
+    /**
+     * Puts every counter back to saved values without completing anything.
+     */
+    void restore(const Counters &saved)
+    {
+        counters = saved;
+    }
+
+    /**
+     * Changes a counter, completing it if that brought it down to 0.
+     */
+    void add(QuestCounter counter, int delta)
+    {
+        bool wasCompleted = isCompleted(counter);
+        counters[static_cast<size_t>(counter)] += delta;
+
+        if (!wasCompleted && isCompleted(counter))
+            complete(counter);
+    }
+
+    /**
+     * Runs callback once the counter completes, right away if it already is,
+     * as long as owner is still around. An owner listens once per counter,
+     * asking again replaces its callback.
+     */
+    void onCompleted(QuestCounter counter, CoreNode *owner, std::function<void()> callback)
+    {
+        if (isCompleted(counter))
+        {
+            callback();
+            return;
+        }
+
+        for (auto &listener : listeners)
+        {
+            if (listener.counter == counter && listener.owner == owner->getHandle())
+            {
+                listener.callback = std::move(callback);
+                return;
+            }
+        }
+
+        listeners.push_back({counter, owner->getHandle(), std::move(callback)});
+    }
+
+private:
+    void complete(QuestCounter counter)
+    {
+        // Taken out first, a callback may register new listeners
+        std::vector<Listener> completed;
+        std::erase_if(listeners, [&](Listener &listener)
+                      {
+                          if (listener.counter != counter)
+                              return false;
+
+                          completed.push_back(std::move(listener));
+                          return true; });
+
+        for (auto &listener : completed)
+            if (NodeHandleTable::get().resolve(listener.owner) != nullptr)
+                listener.callback();
+    }
+};
+
+#pragma endregion Quests
+
+#pragma region Scripts
+
+class ScriptRunner;
+
+/**
+ * Identifies a running script. Stale once the script finished or was stopped.
+ */
+struct ScriptHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+};
+
+/**
+ * @brief Script
+ * A cutscene or conversation written as a coroutine. It starts suspended and
+ * only runs once handed to ScriptRunner::start, which owns it from then on.
+ *
+ *     Script talk()
+ *     {
+ *         co_await say({"ERIK: Hello"});
+ *         co_await game->waitSeconds(1.0f);
+ *         game->enableLevelPortal();
+ *     }
+ */
+class Script
+{
+public:
+    struct promise_type
+    {
+        ScriptRunner *runner = nullptr;
+        ScriptHandle self;
+
+        Script get_return_object()
+        {
+            return Script(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+private:
+    friend class ScriptRunner;
+    std::coroutine_handle<promise_type> coroutine;
+
+    explicit Script(std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine)
+    {
+    }
+
+public:
+    Script(Script &&other) noexcept : coroutine(std::exchange(other.coroutine, nullptr))
+    {
+    }
+
+    Script(const Script &) = delete;
+    Script &operator=(const Script &) = delete;
+
+    ~Script()
+    {
+        if (coroutine)
+            coroutine.destroy();
+    }
+};
+
+/**
+ * @brief ScriptEvent
+ * What a script co_awaits. ready is checked first so a script doesn't
+ * suspend on something that already happened; otherwise subscribe hands the
+ * script's handle to whoever fires the event, which resumes it through the
+ * runner.
+ */
+template <typename Ready, typename Subscribe>
+struct ScriptEvent
+{
+    Ready ready;
+    Subscribe subscribe;
+
+    bool await_ready() { return ready(); }
+    void await_resume() {}
+
+    void await_suspend(std::coroutine_handle<Script::promise_type> coroutine)
+    {
+        subscribe(coroutine.promise().runner, coroutine.promise().self);
+    }
+};
+
+/**
+ * @brief ScriptRunner
+ * Owns the running scripts. A suspended script is only a frame waiting for
+ * its event to call resume(); nothing looks at it per frame. Each script
+ * belongs to a node and is dropped instead of resumed once the node is gone.
+ */
+class ScriptRunner
+{
+private:
+    struct Slot
+    {
+        std::coroutine_handle<Script::promise_type> coroutine;
+        NodeHandle owner;
+        uint32_t generation = 1;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+public:
+    ScriptRunner() = default;
+    ScriptRunner(const ScriptRunner &) = delete;
+    ScriptRunner &operator=(const ScriptRunner &) = delete;
+
+    ~ScriptRunner()
+    {
+        clear();
+    }
+
+    /**
+     * Runs script up to its first co_await and keeps it until it finishes.
+     */
+    ScriptHandle start(CoreNode *owner, Script script)
+    {
+        uint32_t index;
+
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        auto &slot = slots[index];
+        slot.coroutine = std::exchange(script.coroutine, nullptr);
+        slot.owner = owner->getHandle();
+
+        ScriptHandle handle = {index, slot.generation};
+        slot.coroutine.promise().runner = this;
+        slot.coroutine.promise().self = handle;
+        resume(handle);
+        return handle;
+    }
+
+    /**
+     * Continues a script from where it is suspended. Does nothing for
+     * stale handles, so events never need to unsubscribe.
+     */
+    void resume(ScriptHandle handle)
+    {
+        if (!isRunning(handle))
+            return;
+
+        auto coroutine = slots[handle.index].coroutine;
+        if (NodeHandleTable::get().resolve(slots[handle.index].owner) == nullptr)
+        {
+            retire(handle.index);
+            return;
+        }
+
+        // May start other scripts and grow slots, nothing is held across it
+        coroutine.resume();
+
+        if (coroutine.done())
+            retire(handle.index);
+    }
+
+    void stop(ScriptHandle handle)
+    {
+        if (isRunning(handle))
+            retire(handle.index);
+    }
+
+    bool isRunning(ScriptHandle handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].coroutine && slots[handle.index].generation == handle.generation;
+    }
+
+    /**
+     * Destroys every script, wherever it is suspended.
+     */
+    void clear()
+    {
+        for (uint32_t i = 0; i < slots.size(); i++)
+            if (slots[i].coroutine)
+                retire(i);
+    }
+
+private:
+    void retire(uint32_t index)
+    {
+        auto &slot = slots[index];
+        slot.coroutine.destroy();
+        slot.coroutine = nullptr;
+
+        if (++slot.generation == 0)
+            slot.generation = 1;
+
+        freeSlots.push_back(index);
+    }
+};
+
+#pragma endregion Scripts
+
+#pragma region Traversal
+
+/**
+ * @brief FlatTraversal
+ * Pre-order walk of a subtree kept as one contiguous array. Each entry
+ * holds the size of its subtree, so skipping a subtree is an index jump.
+ * The array is rebuilt only after the tree's structure changed, walking it
+ * otherwise touches memory in order and allocates nothing.
+ */
+class FlatTraversal
+{
+public:
+    struct Entry
+    {
+        CoreNode *node;
+        uint32_t subtreeSize;
+    };
+
+private:
+    CoreNode *root = nullptr;
+    std::vector<Entry> entries;
+    uint32_t builtVersion = 0;
+    bool built = false;
+
+public:
+    explicit FlatTraversal(CoreNode *root = nullptr) : root(root)
+    {
+    }
+
+    const std::vector<Entry> &get()
+    {
+        if (isStale())
+            rebuild();
+
+        return entries;
+    }
+
+    bool isStale() const
+    {
+        return !built || builtVersion != CoreNode::getStructureVersion();
+    }
+
+private:
+    void rebuild()
+    {
+        entries.clear();
+
+        if (root)
+            append(root);
+
+        builtVersion = CoreNode::getStructureVersion();
+        built = true;
+    }
+
+    void append(CoreNode *node)
+    {
+        size_t index = entries.size();
+        entries.push_back({node, 1});
+
+        for (auto *child : node->children)
+            if (child)
+                append(child);
+
+        entries[index].subtreeSize = static_cast<uint32_t>(entries.size() - index);
+    }
+};
+
+#pragma endregion Traversal
+
+#pragma region Alignment
+
+enum class HAlign
+{
+    Center,
+    Left,
+    Right,
+};
+
+enum class VAlign
+{
+    Center,
+    Top,
+    Bottom,
+};
+
+#pragma endregion Alignment
+
+#pragma region GameNode
+
+CoreNode *CreateNode(GameNode *node, const EntitySpawn &spawn);
+void ReleaseNode(CoreNode *node);
+bool ReserveNodes(const std::string &type, size_t count);
+bool IsStreamedNode(const std::string &type);
+MiniGame *CreateMiniGame(const std::string &name, GameNode *node);
+void ReleaseMiniGame(MiniGame *game);
+void ReserveMiniGames();
+
+/**
+ * @brief GameData
+ * What worlds read but never write: the baked LDtk project and the dialog
+ * text. Loaded once per process and shared by every world, including all
+ * the worlds of a batch run.
+ */
+struct GameData
+{
+    WorldData world;
+    DialogTable dialogs;
+
+    void load()
+    {
+        world.load("assets/map_project/QuestForTrueColor.ldtk");
+        dialogs.load("assets/dialogs.txt");
+    }
+};
+
+/**
+ * A queued dialog. Its text is looked up in the game's DialogTable, so
+ * queuing one copies a few bytes and nothing else.
+ */
+struct Dialog
+{
+    MessageId message = MessageId::Count;
+    float duration = 1.0f;
+    bool fullscreen = false;
+    bool persistent = false;
+    uint8_t id = 0;
+    uint32_t sequence = 0;
+};
+
+/**
+ * @brief SceneMutation
+ * A structural change to the scene tree requested while it was being
+ * iterated. GameNode applies them in order at the end of its update.
+ */
+struct SceneMutation
+{
+    enum class Type
+    {
+        Add,
+        Destroy,
+        Reparent,
+        MoveToRoot,
+        LoadLevel,
+        Checkpoint,
+    };
+
+    Type type = Type::Add;
+    NodeHandle node = {};
+    NodeHandle target = {};
+    std::string level = {};
+};
+
+/**
+ * @brief SpawnState
+ * What the current level remembers about one of its spawns. Streamed spawns
+ * only have a node while the camera is near; the rest of the time the byte
+ * the node saved is all that is left of it.
+ */
+struct SpawnState
+{
+    CoreNode *node = nullptr;
+    bool streamed = false;
+    bool consumed = false;
+    bool saved = false;
+    uint8_t state = 0;
+};
+
+/**
+ * What a world snapshot records about the node of a spawn.
+ */
+enum class SpawnSnapshot : uint8_t
+{
+    None,
+    Free,
+    Carried,
+};
+
+constexpr uint32_t WorldSnapshotVersion = 4;
+
+class GameNode : public CoreNode
+{
+
+private:
+    GameContext &context;
+    std::string selectedLevel = "level_1";
+    std::string startLevel = "level_1";
+    const WorldData &world;
+    uint16_t currentLevel = NoLevel;
+    LevelArena levelArena;
+    GameImageAssetProvider *backgroundProvider = nullptr;
+    std::vector<olc::utils::geom2d::rect<float> *> colliders;
+    std::vector<olc::utils::geom2d::rect<float> *> onScreenColliders;
+    const DialogTable &dialogTable;
+    PrefabTable prefabs;
+    std::vector<Dialog> dialogs;
+    std::bitset<256> queuedDialogIds;
+    GameFlags flags;
+    Sound *deadSound = nullptr;
+    NodeHandle playerNode;
+    std::vector<SceneMutation> pendingMutations;
+    std::vector<CoreNode *> levelNodes;
+    std::vector<SpawnState> spawnStates;
+    std::vector<NodeHandle> spawnNodes;
+    std::vector<bool> loadedChunks;
+    std::vector<int> loadedChunkList;
+    FlatTraversal traversal{this};
+    PhaseScheduler scheduler;
+    TimerWheel timers;
+    QuestLog quests;
+    ScriptRunner scripts;
+    TimerHandle dialogTimer;
+    uint32_t dialogSequence = 0;
+    std::vector<std::pair<uint32_t, ScriptHandle>> dialogWaiters;
+    std::vector<std::pair<GameFlag, ScriptHandle>> flagWaiters;
+    ActivityGrid sleepers;
+    LevelBodies bodies;
+    std::vector<CoreNode *> awakeNodes;
+    bool awakeNodesDirty = true;
+    std::vector<std::vector<uint32_t>> collectedSpawns;
+    std::vector<std::byte> saveFields;
+    InputDispatcher input;
+    MiniGame *currentMiniGame = nullptr;
+    bool displayingMinigame = false;
+    bool didLoadMusic = false;
+
+public:
+    bool isGameOver = false;
+    Camera camera;
+    GameImageAssetProvider *spritesProvider = nullptr;
+    CoreNode *uiNode = nullptr;
+
+    GameNode(GameContext &context, CoreNode *uiNode, const GameData &data) : CoreNode("Game", nullptr), context(context), world(data.world), dialogTable(data.dialogs)
+    {
+        declareType<GameNode>();
+        onScreenColliders.reserve(100);
+        dialogs.reserve(32);
+        pendingMutations.reserve(16);
+        input.subscribe(InputAction::Enter, this, InputPriority::Dialog);
+        this->uiNode = uiNode;
+
+        // Outlive New Game, which only resets the world
+        saveFields.reserve(4 * 1024);
+        spritesProvider = new GameImageAssetProvider(context, "assets/sprite_project/Sprites.png");
+        deadSound = new Sound(context, "assets/sfx/game_over.wav", 1);
+        reserveNodePools();
+        ReserveMiniGames();
+    }
+
+    GameContext &getContext() override
+    {
+        return context;
+    }
+
+    const WorldData &getWorld()
+    {
+        return world;
+    }
+
+    /**
+     * Sprite sheet position of one of the "world" enum icons.
+     */
+    olc::vf2d getIconPosition(const std::string &name)
+    {
+        auto icon = world.getIcon(name);
+        return {static_cast<float>(icon.x), static_cast<float>(icon.y)};
+    }
+
+    /**
+     * Starts a new game: resets the world's state and loads the start level.
+     * Nothing is read from disk, what doesn't change between games was set
+     * up by the constructor.
+     */
+    void onCreated() override
+    {
+        unloadLevel();
+        CoreNode::onCreated();
+        collectedSpawns.assign(world.levels.size(), {});
+
+        // A new game, or a save that failed halfway, starts from nothing set
+        flags.clear();
+        quests.reset();
+        selectedLevel = startLevel;
+        camera = Camera();
+        timers.clear();
+        loadLevel(selectedLevel);
+        displayingMinigame = false;
+        addDialog({Message("Credits"), 3.0f, true, false});
+        didLoadMusic = false;
+    }
+
+    ~GameNode()
+    {
+        unloadLevel();
+        closeMiniGame();
+        delete spritesProvider;
+        delete deadSound;
+        // ClearMusic();
     }
 
     void setMiniGame(const std::string &game = "ShellGame")
     {
-        if (currentMiniGame != nullptr)
-            delete currentMiniGame;
+        closeMiniGame();
+        currentMiniGame = CreateMiniGame(game, this);
+
+        if (currentMiniGame != nullptr)
+        {
+            displayingMinigame = true;
+            currentMiniGame->onCreated();
+        }
+    }
+
+    bool isMiniGameActive()
+    {
+        if (!currentMiniGame)
+            return false;
+
+        bool isGameOver = currentMiniGame->getIsGameOver();
+
+        if (isGameOver)
+        {
+            auto gameName = currentMiniGame->name;
+            auto didWin = currentMiniGame->getIsGameWon();
+            for (auto &child : children)
+                child->onMiniGameOver(gameName, didWin);
+
+            closeMiniGame();
+        }
+
+        return !isGameOver;
+    }
+
+    /**
+     * Hands the running minigame back to its pool, if there is one.
+     */
+    void closeMiniGame()
+    {
+        if (currentMiniGame != nullptr)
+            ReleaseMiniGame(currentMiniGame);
+
+        currentMiniGame = nullptr;
+        displayingMinigame = false;
+    }
+
+    /**
+     * The level New Game starts on.
+     */
+    void setStartLevel(const std::string &level)
+    {
+        startLevel = level;
+    }
+
+    void loadLevel(const std::string levelName)
+    {
+        auto levelIndex = world.findLevel(levelName);
+        if (levelIndex == NoLevel)
+            return;
+
+        selectedLevel = levelName;
+        clearDialogs();
+        disableLevelPortal();
+        unloadLevel();
+        currentLevel = levelIndex;
+        auto &level = world.levels[currentLevel];
+        backgroundProvider = levelArena.create<GameImageAssetProvider>(context, level.backgroundPath);
+
+        camera.size.x = level.size.x;
+        camera.size.y = level.size.y;
+        sleepers.resize(camera.size);
+        isGameOver = false;
+        deadSound->SetPlayed(false);
+
+        colliders.reserve(level.colliders.size());
+        for (auto &collider : level.colliders)
+            colliders.push_back(levelArena.create<olc::utils::geom2d::rect<float>>(collider));
+
+        startQuests(level);
+        spawnStates.assign(level.spawns.size(), {});
+        spawnNodes.assign(level.spawns.size(), {});
+        loadedChunks.assign(level.chunks.size(), false);
+
+        // Streamed spawns come in with updateStreaming as the camera gets near
+        for (uint32_t i = 0; i < level.spawns.size(); i++)
+        {
+            spawnStates[i].streamed = level.spawns[i].streamable && IsStreamedNode(level.spawns[i].identifier);
+
+            // Collected in an earlier visit, or before the game was saved
+            if (std::binary_search(collectedSpawns[currentLevel].begin(), collectedSpawns[currentLevel].end(), i))
+            {
+                spawnStates[i].consumed = true;
+                continue;
+            }
+
+            if (spawnStates[i].streamed)
+                continue;
+
+            if (auto *node = spawnNode(level, i))
+                levelNodes.push_back(node);
+        }
+
+        uiNode->onCreated();
+        addChild(uiNode);
+
+        for (auto &child : children)
+            child->onAllCreated();
+    }
+
+    bool getFlag(GameFlag flag)
+    {
+        return flags.get(flag);
+    }
+
+    bool setFlag(GameFlag flag, bool value)
+    {
+        flags.set(flag, value);
+
+        // Taken out first, a resumed script may wait on another flag
+        std::vector<ScriptHandle> waking;
+        std::erase_if(flagWaiters, [&](auto &waiter)
+                      {
+                          if (waiter.first != flag || !value)
+                              return false;
+
+                          waking.push_back(waiter.second);
+                          return true; });
+
+        for (auto handle : waking)
+            scripts.resume(handle);
+
+        return value;
+    }
+
+    void drawOverlayDialog()
+    {
+        if (dialogs.empty())
+            return;
+
+        auto currentDialog = &dialogs[0];
+        auto &message = dialogTable.getText(currentDialog->message);
+
+        if (currentDialog->fullscreen)
+        {
+            context.Text(message, olc::WHITE, YAlign::MIDDLE, XAlign::CENTER, {1, 1});
+            return;
+        }
+
+        auto textSize = dialogTable.getSize(currentDialog->message);
+        const auto rectColor = olc::Pixel(0, 0, 0, 150);
+
+        context.Rect({10, 10}, {SCREEN_WIDTH - 20, textSize.y + 20.0f}, rectColor, true);
+        context.Text(message, olc::WHITE, YAlign::TOP, XAlign::LEFT, {1, 1}, {20, 20});
+    }
+
+    /**
+     * Drops every dialog. Scripts waiting on them are abandoned, not resumed.
+     */
+    void clearDialogs()
+    {
+        timers.cancel(dialogTimer);
+        dialogs.clear();
+        queuedDialogIds.reset();
+        dialogWaiters.clear();
+    }
+
+    bool isPersistentDialogOpen()
+    {
+        if (dialogs.empty())
+            return false;
+
+        return dialogs[0].persistent;
+    }
+
+    void popDialog()
+    {
+        if (dialogs.empty())
+            return;
+
+        timers.cancel(dialogTimer);
+        queuedDialogIds.reset(dialogs[0].id);
+        dialogs.erase(dialogs.begin());
+        showFrontDialog();
+        resumeDialogWaiters();
+    }
+
+    bool isFullscreenDialog()
+    {
+        if (dialogs.empty())
+            return false;
+
+        return dialogs[0].fullscreen;
+    }
+
+    /**
+     * The game clock is advanced here and nowhere else: every node gets the
+     * frame time scaled by the clock's time scale.
+     */
+    void onUpdated(float fElapsedTime) override
+    {
+        updateFrame(timers.advance(fElapsedTime));
+        applyMutations();
+    }
 
-        currentMiniGame = CreateMiniGame(game, this);
+    void updateFrame(float fElapsedTime)
+    {
+        // if (!IsPlayingMusic() && !didLoadMusic)
+        // {
+        //     // LoadMusic("assets/sfx/huperboloid.wav");
+        //     didLoadMusic = true;
+        // }
 
-        if (currentMiniGame != nullptr)
+        if (isFullscreenDialog())
         {
-            displayingMinigame = true;
-            currentMiniGame->onCreated();
+            drawOverlayDialog();
+            // StopMusic();
+            return;
+        }
+
+        // if (didLoadMusic)
+        //     ResumeMusic();
+
+        // Drawing background image
+        context.Image(backgroundProvider);
+
+        if (isMiniGameActive())
+        {
+            currentMiniGame->onUpdated(fElapsedTime);
+            drawOverlayDialog();
+            return;
+        }
+
+        updateOnScreenColliders();
+
+        // Adding tiles
+        AssetOptions tileOptions;
+        for (auto &tile : world.levels[currentLevel].tiles)
+        {
+            if (!camera.IsOnScreen(tile.position))
+                continue;
+
+            tileOptions.position = tile.position;
+            camera.WorldToScreen(tileOptions.position);
+            tileOptions.offset = tile.textureOffset;
+            tileOptions.size = tile.size;
+
+            context.Image(spritesProvider, &tileOptions);
+        }
+
+        scheduler.run(UpdatePhase::Input, fElapsedTime);
+        scheduler.run(UpdatePhase::Physics, fElapsedTime);
+        scheduler.run(UpdatePhase::Logic, fElapsedTime, [this](float)
+                      { classifyBodies(); });
+        scheduler.run(UpdatePhase::Animation, fElapsedTime);
+        updateStreaming();
+        updateActivity();
+        scheduler.run(UpdatePhase::Render, fElapsedTime, [this](float fElapsedTime)
+                      { renderNodes(fElapsedTime); });
+
+        drawOverlayDialog();
+        if (isGameOver)
+        {
+            context.Text("Game Over", olc::WHITE, YAlign::MIDDLE, XAlign::CENTER, {2.0, 2.0});
+            context.Text("Press ESC to restart", olc::WHITE, YAlign::MIDDLE, XAlign::CENTER, {1, 1}, {0, 20.0});
+            deadSound->Play(false, false);
+        }
+    }
+
+    bool isDisplayingDialog()
+    {
+        return !dialogs.empty();
+    }
+
+    bool isDisplayingDialogWithId(uint8_t id)
+    {
+        if (dialogs.empty())
+            return false;
+
+        return dialogs[0].id == id;
+    }
+
+    void addDialog(Dialog dialog)
+    {
+        if ((dialog.duration <= 0 && !dialog.persistent) || dialog.message == MessageId::Count)
+            return;
+
+        // One dialog per id in the queue
+        if (queuedDialogIds.test(dialog.id))
+            return;
+
+        dialog.sequence = ++dialogSequence;
+        queuedDialogIds.set(dialog.id);
+        dialogs.push_back(dialog);
+
+        if (dialogs.size() == 1)
+            showFrontDialog();
+    }
+
+    void enableLevelPortal()
+    {
+        this->setFlag(Flag("level_portal"), true);
+    }
+
+    void disableLevelPortal()
+    {
+        this->setFlag(Flag("level_portal"), false);
+    }
+
+    bool isLevelPortalEnabled()
+    {
+        return this->getFlag(Flag("level_portal"));
+    }
+
+    bool hasPersistentDialogShowing()
+    {
+        if (dialogs.empty())
+            return false;
+
+        return dialogs[0].persistent;
+    }
+
+    bool hasPendingDialogWithId(uint8_t id)
+    {
+        return queuedDialogIds.test(id);
+    }
+
+    template <typename T>
+    std::vector<T *> getOnScreenChildrenOfType(bool evaluateScreen = true)
+    {
+        std::vector<T *> output;
+        for (auto *child : getChildrenOfType<T>())
+        {
+            if (!camera.IsOnScreen(child->position) && evaluateScreen)
+                continue;
+
+            output.push_back(static_cast<T *>(child));
+        }
+
+        return output;
+    }
+
+    InputDispatcher &getInput()
+    {
+        return input;
+    }
+
+    PhaseScheduler &getScheduler()
+    {
+        return scheduler;
+    }
+
+    TimerWheel &getTimers()
+    {
+        return timers;
+    }
+
+    PrefabTable &getPrefabs()
+    {
+        return prefabs;
+    }
+
+    QuestLog &getQuests()
+    {
+        return quests;
+    }
+
+    LevelBodies &getBodies()
+    {
+        return bodies;
+    }
+
+    /**
+     * Copies where a node stands and whether it is carried into its body,
+     * for the nodes that have one.
+     */
+    void placeBody(CoreNode *node)
+    {
+        bodies.place(node->body, node->position);
+        bodies.set(node->body, LevelBodies::Free, node->getParent() == nullptr);
+    }
+
+    ScriptRunner &getScripts()
+    {
+        return scripts;
+    }
+
+    /**
+     * Script event: every dialog queued so far is gone, dismissed or timed out.
+     */
+    auto waitForDialogs()
+    {
+        uint32_t sequence = dialogSequence;
+        return ScriptEvent{[this, sequence]()
+                           { return areDialogsDismissed(sequence); },
+                           [this, sequence](ScriptRunner *, ScriptHandle script)
+                           { dialogWaiters.push_back({sequence, script}); }};
+    }
+
+    /**
+     * Script event: seconds of game time went by.
+     */
+    auto waitSeconds(float seconds)
+    {
+        return ScriptEvent{[]()
+                           { return false; },
+                           [this, seconds](ScriptRunner *runner, ScriptHandle script)
+                           { timers.after(seconds, nullptr, [runner, script]()
+                                          { runner->resume(script); }); }};
+    }
+
+    /**
+     * Script event: flag is set.
+     */
+    auto waitForFlag(GameFlag flag)
+    {
+        return ScriptEvent{[this, flag]()
+                           { return getFlag(flag); },
+                           [this, flag](ScriptRunner *, ScriptHandle script)
+                           { flagWaiters.push_back({flag, script}); }};
+    }
+
+    /**
+     * Seconds of game time, stands still while paused and slows down with
+     * the time scale.
+     */
+    float getTime() const
+    {
+        return timers.now();
+    }
+
+    /**
+     * Saves the world's mutable state into snapshot: every spawn's node or
+     * what is left of it, the player's items, flags, quests, the clock,
+     * dialogs, the camera and the random numbers. Allocates nothing, the
+     * snapshot's buffer is written in place. Returns false if the world
+     * didn't fit, leaving the snapshot empty.
+     *
+     * Only called outside of the update loop, at the sync point or from the
+     * menu and console. Running scripts and minigames aren't saved.
+     */
+    bool saveSnapshot(WorldSnapshot &snapshot)
+    {
+        auto &table = NodeHandleTable::get();
+        SnapshotWriter writer(snapshot);
+
+        writer.write(WorldSnapshotVersion);
+        writer.write(currentLevel);
+        writer.write(static_cast<uint32_t>(spawnStates.size()));
+
+        for (uint32_t i = 0; i < spawnStates.size(); i++)
+        {
+            auto &state = spawnStates[i];
+            writer.write(getSpawnSnapshot(i));
+            writer.write(state.consumed);
+            writer.write(state.saved);
+            writer.write(state.state);
+        }
+
+        writer.write(static_cast<uint16_t>(loadedChunkList.size()));
+        for (int chunk : loadedChunkList)
+            writer.write(static_cast<int32_t>(chunk));
+
+        // Spawn indices of the player's items, in the order they were picked up
+        auto *player = table.resolve(playerNode);
+        uint8_t carried = 0;
+
+        if (player != nullptr)
+            for (auto *item : player->children)
+                carried += findSpawn(item) != UINT32_MAX;
+
+        writer.write(carried);
+
+        if (player != nullptr)
+            for (auto *item : player->children)
+                if (auto index = findSpawn(item); index != UINT32_MAX)
+                    writer.write(index);
+
+        writer.write(isGameOver);
+        writer.write(timers.now());
+        writer.write(timers.getTimeScale());
+        writer.write(flags);
+        writer.write(quests.getCounters());
+        writer.write(camera.size);
+        writer.write(camera.position);
+        writer.write(camera.offset);
+        writer.write(camera.zoom);
+        writer.write(context.random.getState());
+
+        writer.write(static_cast<uint8_t>(dialogs.size()));
+        for (auto &dialog : dialogs)
+            writer.write(dialog);
+
+        writer.write(timers.remaining(dialogTimer));
+
+        for (uint32_t i = 0; i < spawnNodes.size(); i++)
+            if (getSpawnSnapshot(i) != SpawnSnapshot::None)
+                table.resolve(spawnNodes[i])->onSnapshot(writer);
+
+        return writer.finish();
+    }
+
+    /**
+     * Puts the world back to a snapshot, switching levels first if it was
+     * taken in another one. Nodes that still exist are restored in place,
+     * only the ones destroyed or streamed out since are spawned again.
+     * Running scripts, the minigame and every timer are dropped; nodes
+     * schedule their timers again while restoring. Same rules as
+     * saveSnapshot about when it can be called.
+     */
+    bool restoreSnapshot(const WorldSnapshot &snapshot)
+    {
+        return restoreSnapshot(SnapshotReader(snapshot));
+    }
+
+    bool restoreSnapshot(SnapshotReader reader)
+    {
+        if (reader.read<uint32_t>() != WorldSnapshotVersion)
+            return false;
+
+        auto level = reader.read<uint16_t>();
+        auto spawnCount = reader.read<uint32_t>();
+
+        if (level >= world.levels.size() || world.levels[level].spawns.size() != spawnCount)
+            return false;
+
+        if (level != currentLevel)
+            loadLevel(world.levels[level].name);
+
+        scripts.clear();
+        dialogWaiters.clear();
+        flagWaiters.clear();
+        closeMiniGame();
+        restoreSpawns(reader);
+
+        reader.read(isGameOver);
+        timers.rewind(reader.read<float>());
+        timers.setTimeScale(reader.read<float>());
+        reader.read(flags);
+        quests.restore(reader.read<QuestLog::Counters>());
+        reader.read(camera.size);
+        reader.read(camera.position);
+        reader.read(camera.offset);
+        reader.read(camera.zoom);
+        auto random = reader.read<GameRandom::State>();
+        if (!reader.hasFailed())
+            context.random.setState(random);
+        restoreDialogs(reader);
+
+        auto &table = NodeHandleTable::get();
+        for (auto handle : spawnNodes)
+            if (auto *node = table.resolve(handle))
+                node->onRestore(reader);
+
+        // Everything starts awake, the next update puts the far nodes back to sleep
+        sleepers.clear();
+        for (auto *child : children)
+            child->sleeping = false;
+
+        bodies.setAll(LevelBodies::Awake);
+        awakeNodesDirty = true;
+
+        if (!isGameOver)
+            deadSound->SetPlayed(false);
+
+        return !reader.hasFailed();
+    }
+
+    /**
+     * Saves the game to disk in the background, when the world has somewhere
+     * to save to. A save holds the level, the flags, what was collected in
+     * every level visited and what the player keeps, not the world itself:
+     * loading it spawns the level afresh.
+     */
+    void saveGame()
+    {
+        auto *player = NodeHandleTable::get().resolve(playerNode);
+        if (context.saves == nullptr || currentLevel == NoLevel || player == nullptr)
+            return;
+
+        recordCollected();
+
+        SaveDataWriter writer(saveFields);
+        writer.writeString(world.levels[currentLevel].name);
+
+        // Flags by key, so adding or reordering flags keeps older saves valid
+        uint16_t flagCount = 0;
+        for (size_t i = 0; i < static_cast<size_t>(GameFlag::Count); i++)
+            flagCount += flags.get(static_cast<GameFlag>(i));
+
+        writer.writeU16(flagCount);
+        for (size_t i = 0; i < static_cast<size_t>(GameFlag::Count); i++)
+            if (flags.get(static_cast<GameFlag>(i)))
+                writer.writeU32(GameFlagKeys[i]);
+
+        uint16_t levelCount = 0;
+        for (auto &collected : collectedSpawns)
+            levelCount += !collected.empty();
+
+        writer.writeU16(levelCount);
+        for (size_t i = 0; i < collectedSpawns.size(); i++)
+        {
+            if (collectedSpawns[i].empty())
+                continue;
+
+            writer.writeString(world.levels[i].name);
+            writer.writeU32(static_cast<uint32_t>(collectedSpawns[i].size()));
+            for (auto index : collectedSpawns[i])
+                writer.writeU32(index);
+        }
+
+        player->onSaveGame(writer);
+        context.saves->submit(saveFields);
+    }
+
+    /**
+     * Continues from a save file, read straight out of its mapping. Returns
+     * false if there is none or it doesn't check out, in which case the
+     * world is left as a new game.
+     */
+    bool loadGame(const std::string &path)
+    {
+        MappedSaveGame save(path);
+        if (!save.isValid())
+            return false;
+
+        auto reader = save.getReader();
+        auto level = reader.readString();
+        if (world.findLevel(level) == NoLevel)
+            return false;
+
+        // The level being left would record over what the save collected
+        unloadLevel();
+        flags.clear();
+
+        // Keys of flags that no longer exist are skipped
+        for (auto count = reader.readU16(); count > 0 && !reader.hasFailed(); count--)
+        {
+            auto key = reader.readU32();
+            for (size_t i = 0; i < static_cast<size_t>(GameFlag::Count); i++)
+                if (GameFlagKeys[i] == key)
+                    flags.set(static_cast<GameFlag>(i), true);
+        }
+
+        collectedSpawns.assign(world.levels.size(), {});
+        for (auto count = reader.readU16(); count > 0 && !reader.hasFailed(); count--)
+        {
+            auto index = world.findLevel(reader.readString());
+            auto spawnCount = reader.readU32();
+            std::vector<uint32_t> collected;
+
+            for (uint32_t i = 0; i < spawnCount && !reader.hasFailed(); i++)
+                collected.push_back(reader.readU32());
+
+            // Levels no longer in the world are skipped
+            if (index != NoLevel)
+            {
+                std::sort(collected.begin(), collected.end());
+                collectedSpawns[index] = std::move(collected);
+            }
         }
+
+        loadLevel(level);
+
+        if (auto *player = NodeHandleTable::get().resolve(playerNode))
+            player->onLoadGame(reader);
+
+        if (!reader.hasFailed())
+            return true;
+
+        onCreated();
+        return false;
+    }
+
+    /**
+     * Entry point for the frame's input, delivered to subscribers only.
+     */
+    void handleInput(InputAction action)
+    {
+        input.dispatch(action);
+    }
+
+    /**
+     * Dialogs come first: dismissing a persistent one swallows the key.
+     */
+    bool onInput(InputAction action) override
+    {
+        if (action != InputAction::Enter || !isPersistentDialogOpen())
+            return false;
+
+        popDialog();
+        return true;
+    }
+
+    void onGameOver()
+    {
+        isGameOver = true;
+    }
+
+    LevelArena &getLevelArena()
+    {
+        return levelArena;
+    }
+
+    std::vector<olc::utils::geom2d::rect<float> *> &getOnScreenColliders()
+    {
+        return onScreenColliders;
+    }
+
+    /**
+     * Queues a node to be added under parent (the game when null).
+     */
+    void queueAdd(CoreNode *node, CoreNode *parent = nullptr)
+    {
+        queueMutation(SceneMutation::Type::Add, node, parent);
+    }
+
+    /**
+     * Queues a node to be detached from the tree, after which its handles go
+     * stale. Until then it is skipped by updates and input. The node goes
+     * back to its pool on the next level load.
+     */
+    void destroyNode(CoreNode *node)
+    {
+        if (node == nullptr || node->isDestroyed())
+            return;
+
+        node->destroyed = true;
+        queueMutation(SceneMutation::Type::Destroy, node);
+    }
+
+    void queueReparent(CoreNode *node, CoreNode *newParent)
+    {
+        queueMutation(SceneMutation::Type::Reparent, node, newParent);
+    }
+
+    /**
+     * Queues a node to be moved from its parent back to the game.
+     */
+    void queueMoveToRoot(CoreNode *node)
+    {
+        queueMutation(SceneMutation::Type::MoveToRoot, node);
+    }
+
+    void queueLoadLevel(const std::string &levelName)
+    {
+        pendingMutations.push_back({SceneMutation::Type::LoadLevel, {}, {}, levelName});
+    }
+
+    /**
+     * Queues saving the game at a checkpoint.
+     */
+    void queueCheckpoint()
+    {
+        pendingMutations.push_back({SceneMutation::Type::Checkpoint});
     }
 
-    bool isMiniGameActive()
-    {
-        if (!currentMiniGame)
-            return false;
+    /**
+     * The scene's sync point: runs every queued mutation in order. Mutations
+     * queued behind a level switch whose nodes did not survive it are dropped.
+     */
+    void applyMutations()
+    {
+        auto &table = NodeHandleTable::get();
+
+        // Index loop, applying a mutation may queue more
+        for (size_t i = 0; i < pendingMutations.size(); i++)
+        {
+            auto mutation = pendingMutations[i];
+            auto *target = table.resolve(mutation.target);
+
+            if (mutation.type == SceneMutation::Type::LoadLevel)
+            {
+                loadLevel(mutation.level);
+                saveGame();
+                continue;
+            }
+
+            if (mutation.type == SceneMutation::Type::Checkpoint)
+            {
+                saveGame();
+                continue;
+            }
+
+            auto *node = table.resolve(mutation.node);
+            if (node == nullptr)
+                continue;
+
+            // Nodes being moved around are wanted awake
+            wakeNode(node);
+
+            // And once picked up or destroyed they no longer belong to their spawn
+            if (node->spawnIndex >= 0)
+                adoptSpawnedNode(node);
+
+            switch (mutation.type)
+            {
+            case SceneMutation::Type::Destroy:
+                if (auto *parent = node->getParent())
+                    parent->removeChild(node);
+
+                removeChild(node);
+                removeBody(node);
+                node->release();
+                break;
+
+            case SceneMutation::Type::Add:
+                node->setParent(target);
+                (target ? target : this)->addChild(node);
+                placeBody(node);
+                break;
 
-        bool isGameOver = currentMiniGame->getIsGameOver();
+            case SceneMutation::Type::Reparent:
+                if (target != nullptr)
+                    node->reparent(target);
 
-        if (isGameOver)
-        {
-            auto gameName = currentMiniGame->name;
-            auto didWin = currentMiniGame->getIsGameWon();
-            for (auto &child : children)
-                child->onMiniGameOver(gameName, didWin);
+                placeBody(node);
+                break;
+
+            case SceneMutation::Type::MoveToRoot:
+                if (auto *parent = node->getParent())
+                    parent->moveChildToRoot(node, this);
+
+                placeBody(node);
+                break;
 
-            delete currentMiniGame;
-            currentMiniGame = nullptr;
-            displayingMinigame = false;
+            default:
+                break;
+            }
         }
 
-        return !isGameOver;
+        pendingMutations.clear();
     }
 
-    void loadLevel(const std::string levelName)
+    template <typename T>
+    T *getChild()
     {
-        auto &allLevels = project.getWorld().allLevels();
-        bool didFind = false;
-        for (auto &level : allLevels)
-            if (level.name == levelName)
-            {
-                didFind = true;
-                break;
-            }
+        auto &matches = getChildrenOfType<T>();
+        return matches.empty() ? nullptr : static_cast<T *>(matches.front());
+    }
 
-        if (!didFind)
+private:
+    /**
+     * Starts the countdown of the dialog that just got to the front. Persistent
+     * dialogs stay until dismissed.
+     */
+    void showFrontDialog()
+    {
+        if (dialogs.empty() || dialogs[0].persistent)
             return;
 
-        selectedLevel = levelName;
-        colliders.clear();
-        clearDialogs();
-        disableLevelPortal();
-        clearChildren();
-        auto &world = project.getWorld();
-        auto &level = world.getLevel(selectedLevel);
-        auto &bgImage = level.getBgImage();
-        const auto bgImagePath = bgImage.path.c_str();
-        auto fullImagePath = "assets/map_project/" + std::string(bgImagePath);
-        backgroundProvider = new GameImageAssetProvider(fullImagePath);
+        dialogTimer = timers.after(dialogs[0].duration, this, [this]()
+                                   { popDialog(); });
+    }
 
-        camera.size.x = level.size.x;
-        camera.size.y = level.size.y;
-        isGameOver = false;
-        deadSound->SetPlayed(false);
+    bool areDialogsDismissed(uint32_t sequence)
+    {
+        return dialogs.empty() || dialogs[0].sequence > sequence;
+    }
 
-        auto &collidersLayer = level.getLayer("colliders");
-        for (int x = 0; x < collidersLayer.getGridSize().x; x++)
-        {
-            for (int y = 0; y < collidersLayer.getGridSize().y; y++)
-            {
-                auto intGridVal = collidersLayer.getIntGridVal(x, y);
-                if (intGridVal.value > 0)
-                {
-                    auto offset = collidersLayer.getOffset();
-                    olc::vf2d offsetPos = {static_cast<float>(offset.x), static_cast<float>(offset.y)};
-                    olc::vf2d pos = {static_cast<float>(x * collidersLayer.getCellSize()), static_cast<float>(y * collidersLayer.getCellSize())};
-                    pos += offsetPos;
-                    olc::vf2d size = {static_cast<float>(collidersLayer.getCellSize()), static_cast<float>(collidersLayer.getCellSize())};
-                    colliders.push_back(new olc::utils::geom2d::rect<float>(pos, size));
-                }
-            }
-        }
+    void resumeDialogWaiters()
+    {
+        // Taken out first, a resumed script may queue dialogs and wait again
+        std::vector<ScriptHandle> waking;
+        std::erase_if(dialogWaiters, [&](auto &waiter)
+                      {
+                          if (!areDialogsDismissed(waiter.first))
+                              return false;
 
-        auto &entitiesLayer = level.getLayer("entities");
-        auto &entities = entitiesLayer.allEntities();
+                          waking.push_back(waiter.second);
+                          return true; });
 
-        for (auto &entity : entities)
-        {
-            auto *node = CreateNode(this, entity);
+        for (auto handle : waking)
+            scripts.resume(handle);
+    }
 
-            if (!node)
-                continue;
+    void queueMutation(SceneMutation::Type type, CoreNode *node, CoreNode *target = nullptr)
+    {
+        pendingMutations.push_back({type, node->getHandle(), target ? target->getHandle() : NodeHandle()});
+    }
 
-            node->game = this;
-            node->onCreated();
+    /**
+     * Drawing entities, player behind everything and the UI on top. Nodes
+     * that don't split their update into phases do all of it here, in the
+     * children's order.
+     */
+    void renderNodes(float fElapsedTime)
+    {
+        auto *player = NodeHandleTable::get().resolve(playerNode);
+        if (player != nullptr)
+            player->onUpdated(fElapsedTime);
 
-            if (node->name == "player")
-                playerNode = node;
+        for (auto *child : awakeNodes)
+        {
+            if (bodies.isCulledOut(child->body) || child == player || child == uiNode || child->isDestroyed())
+                continue;
 
-            addChild(node);
+            child->onUpdated(fElapsedTime);
         }
 
-        uiNode->onCreated();
-        addChild(uiNode);
-
-        for (auto &child : children)
-            child->onAllCreated();
+        uiNode->onUpdated(fElapsedTime);
     }
 
-    bool getFlag(std::string flag)
+    /**
+     * Counts what the level's quests start from out of its spawns, before any
+     * node exists to listen for them.
+     */
+    void startQuests(const LevelData &level)
     {
-        return flags[flag];
+        quests.reset();
+
+        int madBees = 0;
+        for (auto &spawn : level.spawns)
+            if (spawn.getFields<BeeFields>().isMad)
+                madBees++;
+
+        quests.set(QuestCounter::MadBees, madBees);
     }
 
-    bool setFlag(std::string flag, bool value)
+    CoreNode *spawnNode(const LevelData &level, uint32_t index)
     {
-        flags[flag] = value;
-        return value;
+        auto *node = CreateNode(this, level.spawns[index]);
+        if (!node)
+            return nullptr;
+
+        spawnNodes[index] = node->getHandle();
+
+        node->game = this;
+        node->onCreated();
+
+        static thread_local const NameId playerName = NodeNames::intern("player");
+        if (node->nameId == playerName)
+            playerNode = node->getHandle();
+
+        addChild(node);
+        return node;
     }
 
-    void drawOverlayDialog(float fElapsedTime)
+    /**
+     * Streams in the spawns of chunks around the camera and streams out the
+     * ones of chunks that got far. Nodes stream out a chunk further away than
+     * they stream in, so walking along a chunk border doesn't churn them.
+     */
+    void updateStreaming()
     {
-        if (dialogs.empty())
+        if (currentLevel == NoLevel)
             return;
 
-        auto currentDialog = &dialogs[0];
-        currentDialog->duration -= fElapsedTime;
+        auto &level = world.levels[currentLevel];
+        auto loadArea = camera.GetViewRect(SpawnChunkSize * 0.5f);
+        auto keepArea = camera.GetViewRect(SpawnChunkSize * 1.5f);
+        auto first = level.chunkOf(loadArea.pos);
+        auto last = level.chunkOf(loadArea.pos + loadArea.size);
 
-        if (currentDialog->duration <= 0 && !currentDialog->persistent)
+        for (int y = first.y; y <= last.y; y++)
+            for (int x = first.x; x <= last.x; x++)
+                streamInChunk(level, level.chunkIndex({x, y}));
+
+        auto keepFirst = level.chunkOf(keepArea.pos);
+        auto keepLast = level.chunkOf(keepArea.pos + keepArea.size);
+
+        for (size_t i = 0; i < loadedChunkList.size();)
         {
-            dialogs.erase(dialogs.begin());
-            return;
+            int chunk = loadedChunkList[i];
+            int x = chunk % level.chunkCount.x;
+            int y = chunk / level.chunkCount.x;
+
+            if (x >= keepFirst.x && x <= keepLast.x && y >= keepFirst.y && y <= keepLast.y)
+            {
+                i++;
+                continue;
+            }
+
+            streamOutChunk(level, chunk);
+            loadedChunkList[i] = loadedChunkList.back();
+            loadedChunkList.pop_back();
         }
+    }
 
-        if (currentDialog->fullscreen)
-        {
-            Text(currentDialog->message, olc::WHITE, YAlign::MIDDLE, XAlign::CENTER, {1, 1});
+    void streamInChunk(const LevelData &level, int chunk)
+    {
+        if (loadedChunks[chunk])
             return;
-        }
 
-        auto textSize = TextSize(currentDialog->message);
-        const auto rectColor = olc::Pixel(0, 0, 0, 150);
+        loadedChunks[chunk] = true;
+        loadedChunkList.push_back(chunk);
+
+        for (auto index : level.chunks[chunk])
+        {
+            auto &state = spawnStates[index];
+            if (!state.streamed || state.consumed || state.node != nullptr)
+                continue;
+
+            state.node = spawnNode(level, index);
+            if (state.node == nullptr)
+                continue;
+
+            state.node->spawnIndex = static_cast<int32_t>(index);
+            if (state.saved)
+                state.node->onStreamIn(state.state);
 
-        Rect({10, 10}, {SCREEN_WIDTH - 20, textSize.y + 20.0f}, rectColor, true);
-        Text(currentDialog->message, olc::WHITE, YAlign::TOP, XAlign::LEFT, {1, 1}, {20, 20});
+            state.node->onAllCreated();
+        }
     }
 
-    void clearDialogs()
+    void streamOutChunk(const LevelData &level, int chunk)
     {
-        dialogs.clear();
+        loadedChunks[chunk] = false;
+
+        for (auto index : level.chunks[chunk])
+        {
+            auto &state = spawnStates[index];
+            auto *node = state.node;
+
+            // Nodes queued to be destroyed are adopted when that is applied
+            if (node == nullptr || node->isDestroyed())
+                continue;
+
+            state.state = node->onStreamOut();
+            state.saved = true;
+            state.node = nullptr;
+
+            removeChild(node);
+            removeBody(node);
+            node->release();
+            ReleaseNode(node);
+        }
     }
 
-    bool isPersistentDialogOpen()
+    /**
+     * Hands a streamed node over to the level for good, its spawn won't
+     * stream in again. Its memory goes back with the level's other nodes.
+     */
+    void adoptSpawnedNode(CoreNode *node)
     {
-        if (dialogs.empty())
-            return false;
-
-        return dialogs[0].persistent;
+        auto &state = spawnStates[node->spawnIndex];
+        state.node = nullptr;
+        state.consumed = true;
+        node->spawnIndex = -1;
+        levelNodes.push_back(node);
     }
 
-    void popDialog()
+    SpawnSnapshot getSpawnSnapshot(uint32_t index)
     {
-        if (dialogs.empty())
-            return;
+        auto *node = NodeHandleTable::get().resolve(spawnNodes[index]);
 
-        dialogs.erase(dialogs.begin());
+        if (node == nullptr || node->isDestroyed())
+            return SpawnSnapshot::None;
+
+        return node->getParent() != nullptr ? SpawnSnapshot::Carried : SpawnSnapshot::Free;
     }
 
-    bool isFullscreenDialog()
+    uint32_t findSpawn(CoreNode *node)
     {
-        if (dialogs.empty())
-            return false;
+        for (uint32_t i = 0; i < spawnNodes.size(); i++)
+            if (spawnNodes[i] == node->getHandle())
+                return i;
 
-        return dialogs[0].fullscreen;
+        return UINT32_MAX;
     }
 
-    void onUpdated(float fElapsedTime) override
+    /**
+     * Makes the spawns match a snapshot: drops the nodes it doesn't have,
+     * spawns the ones it has that are gone and hands each to its spawn or
+     * the level the way streaming and adoption would have.
+     */
+    void restoreSpawns(SnapshotReader &reader)
     {
-        // if (!IsPlayingMusic() && !didLoadMusic)
-        // {
-        //     // LoadMusic("assets/sfx/huperboloid.wav");
-        //     didLoadMusic = true;
-        // }
+        auto &table = NodeHandleTable::get();
+        auto &level = world.levels[currentLevel];
+        auto *player = table.resolve(playerNode);
 
-        if (isFullscreenDialog())
+        // Carried items are put back in the snapshot's order below
+        if (player != nullptr)
         {
-            drawOverlayDialog(fElapsedTime);
-            // StopMusic();
-            return;
+            for (auto *item : player->children)
+                item->setParent(nullptr);
+
+            player->clearChildren();
         }
 
-        // if (didLoadMusic)
-        //     ResumeMusic();
+        // Nodes destroyed since the level loaded go back to their pools now,
+        // the ones the snapshot wants are spawned again
+        std::erase_if(levelNodes, [](CoreNode *node)
+                      {
+                          if (!node->isReleased())
+                              return false;
 
-        // Drawing background image
-        Image(backgroundProvider);
+                          ReleaseNode(node);
+                          return true; });
 
-        if (isMiniGameActive())
+        for (uint32_t i = 0; i < spawnStates.size(); i++)
         {
-            currentMiniGame->onUpdated(fElapsedTime);
-            drawOverlayDialog(fElapsedTime);
-            return;
-        }
+            auto &state = spawnStates[i];
+            auto *node = table.resolve(spawnNodes[i]);
+            bool ownedBySpawn = node != nullptr && state.node == node;
 
-        updateOnScreenColliders();
+            auto status = reader.read<SpawnSnapshot>();
+            reader.read(state.consumed);
+            reader.read(state.saved);
+            reader.read(state.state);
 
-        auto &world = project.getWorld();
-        auto &level = world.getLevel(selectedLevel);
+            if (status == SpawnSnapshot::None)
+            {
+                if (node != nullptr)
+                    dropSpawnNode(node, ownedBySpawn);
 
-        // Adding tiles
-        auto &platform = level.getLayer("platform");
-        int skipped = 0;
-        for (auto &tile : platform.allTiles())
-        {
-            auto rect = tile.getTextureRect();
-            auto tileWorldPosition = tile.getPosition();
+                state.node = nullptr;
+                continue;
+            }
 
-            if (!camera.IsOnScreen(tileWorldPosition))
+            bool spawned = node == nullptr;
+            if (spawned)
             {
-                skipped++;
-                continue;
+                node = spawnNode(level, i);
+                if (node == nullptr)
+                {
+                    state.node = nullptr;
+                    continue;
+                }
+
+                node->onAllCreated();
             }
 
-            auto *options = new AssetOptions();
-            olc::vf2d itemPosition = {static_cast<float>(tileWorldPosition.x), static_cast<float>(tileWorldPosition.y)};
-            camera.WorldToScreen(itemPosition);
+            // Queued to be destroyed in the timeline that was left
+            node->destroyed = false;
 
-            options->position = itemPosition;
-            options->offset = olc::vf2d{(float)rect.x, (float)rect.y};
-            options->size = olc::vf2d{(float)rect.width, (float)rect.height};
+            if (state.streamed && !state.consumed)
+            {
+                if (!ownedBySpawn && !spawned)
+                    std::erase(levelNodes, node);
+
+                state.node = node;
+                node->spawnIndex = static_cast<int32_t>(i);
+            }
+            else
+            {
+                if (ownedBySpawn || spawned)
+                    levelNodes.push_back(node);
 
-            Image(spritesProvider, options);
+                state.node = nullptr;
+                node->spawnIndex = -1;
+            }
         }
 
-        // Drawing entities, player behind everything
-        if (playerNode != nullptr)
-            playerNode->onUpdated(fElapsedTime);
+        std::fill(loadedChunks.begin(), loadedChunks.end(), false);
+        loadedChunkList.clear();
 
-        for (auto &child : children)
+        auto chunkCount = reader.read<uint16_t>();
+        for (uint16_t i = 0; i < chunkCount; i++)
         {
-            if (child == playerNode)
+            auto chunk = reader.read<int32_t>();
+            if (chunk < 0 || chunk >= static_cast<int32_t>(loadedChunks.size()))
                 continue;
 
-            child->onUpdated(fElapsedTime);
+            loadedChunks[chunk] = true;
+            loadedChunkList.push_back(chunk);
         }
 
-        drawOverlayDialog(fElapsedTime);
-        if (isGameOver)
+        auto carried = reader.read<uint8_t>();
+        for (uint8_t i = 0; i < carried; i++)
         {
-            Text("Game Over", olc::WHITE, YAlign::MIDDLE, XAlign::CENTER, {2.0, 2.0});
-            Text("Press ESC to restart", olc::WHITE, YAlign::MIDDLE, XAlign::CENTER, {1, 1}, {0, 20.0});
-            deadSound->Play(false, false);
+            auto index = reader.read<uint32_t>();
+            auto *item = index < spawnNodes.size() ? table.resolve(spawnNodes[index]) : nullptr;
+
+            if (item == nullptr || player == nullptr)
+                continue;
+
+            item->setParent(player);
+            player->addChild(item);
         }
     }
 
-    bool isDisplayingDialog()
+    void dropSpawnNode(CoreNode *node, bool ownedBySpawn)
     {
-        return !dialogs.empty();
-    }
+        if (auto *parent = node->getParent())
+            parent->removeChild(node);
 
-    bool isDisplayingDialogWithId(uint8_t id)
-    {
-        if (dialogs.empty())
-            return false;
+        removeChild(node);
+        removeBody(node);
+        node->release();
 
-        return dialogs[0].id == id;
+        if (!ownedBySpawn)
+            std::erase(levelNodes, node);
+
+        ReleaseNode(node);
     }
 
-    void addDialog(Dialog dialog)
+    void restoreDialogs(SnapshotReader &reader)
     {
-        if (dialog.duration <= 0 && !dialog.persistent || dialog.message.empty())
-            return;
-
-        for (auto &d : dialogs)
-            if (d.id == dialog.id)
-                return;
+        dialogs.clear();
+        queuedDialogIds.reset();
 
-        dialogs.push_back(dialog);
-    }
+        auto count = reader.read<uint8_t>();
+        for (uint8_t i = 0; i < count; i++)
+        {
+            auto dialog = reader.read<Dialog>();
+            dialog.sequence = ++dialogSequence;
+            queuedDialogIds.set(dialog.id);
+            dialogs.push_back(dialog);
+        }
 
-    void enableLevelPortal()
-    {
-        this->setFlag("level_portal", true);
+        // The front dialog picks up its countdown where it was
+        auto frontTimeLeft = reader.read<float>();
+        if (!dialogs.empty() && !dialogs[0].persistent)
+            dialogTimer = timers.after(frontTimeLeft, this, [this]()
+                                       { popDialog(); });
     }
 
-    void disableLevelPortal()
+    /**
+     * Only free standing level entities sleep. The player, the UI and items
+     * carried by the player are always updated.
+     */
+    bool canSleep(CoreNode *node)
     {
-        this->setFlag("level_portal", false);
+        return node->sleepable && node->getParent() == nullptr && !node->isDestroyed();
     }
 
-    bool isLevelPortalEnabled()
+    /**
+     * Wakes the sleeping nodes near the camera and puts awake nodes that
+     * wandered off to sleep. Nodes sleep a cell further out than they wake,
+     * so one sitting on the edge doesn't flip every frame. The awake list
+     * keeps the children's order and is only rebuilt when it changed.
+     */
+    void updateActivity()
     {
-        return this->getFlag("level_portal");
-    }
+        constexpr float wakeMargin = 128.0f;
+        constexpr float sleepMargin = 384.0f;
 
-    bool hasPersistentDialogShowing()
-    {
-        if (dialogs.empty())
-            return false;
+        sleepers.wake(camera.GetViewRect(wakeMargin), [this](NodeHandle handle)
+                      {
+                          auto *node = NodeHandleTable::get().resolve(handle);
+                          if (node == nullptr || !node->sleeping)
+                              return;
 
-        return dialogs[0].persistent;
-    }
+                          wakeNode(node); });
 
-    bool hasPendingDialogWithId(uint8_t id)
-    {
-        if (dialogs.empty())
-            return false;
+        // Every node that may sleep has a body, so only the far ones are visited
+        bodies.sleepOutside(camera.GetViewRect(sleepMargin), [this](NodeHandle handle, olc::vf2d position)
+                            {
+                                auto *node = NodeHandleTable::get().resolve(handle);
+                                if (node == nullptr || !canSleep(node))
+                                    return false;
 
-        for (auto &dialog : dialogs)
-            if (dialog.id == id && (dialog.duration > 0 || dialog.persistent))
-                return true;
+                                node->sleeping = true;
+                                sleepers.insert(handle, position);
+                                awakeNodesDirty = true;
+                                return true; });
 
-        return false;
+        refreshAwakeNodes();
     }
 
-    template <typename T>
-    std::vector<T *> getOnScreenChildrenOfType(bool evaluateScreen = true)
+    void wakeNode(CoreNode *node)
     {
-        std::vector<T *> output;
-        for (auto &child : children)
-        {
-            if (!camera.IsOnScreen(child->position) && evaluateScreen)
-                continue;
-
-            auto eval = dynamic_cast<T *>(child);
-            if (eval != nullptr)
-                output.push_back(eval);
-        }
-
-        return output;
+        node->sleeping = false;
+        bodies.set(node->body, LevelBodies::Awake, true);
+        awakeNodesDirty = true;
     }
 
-    void onUp() override
+    void removeBody(CoreNode *node)
     {
-        CoreNode::onUp();
-
-        for (auto &child : children)
-            child->onUp();
+        bodies.remove(node->body);
+        node->body = LevelBodies::NoBody;
     }
 
-    void onDown() override
+    /**
+     * The logic phase's pass over the level's bodies: which are on screen
+     * and which the player touches, for the nodes to read instead of testing
+     * themselves.
+     */
+    void classifyBodies()
     {
-        CoreNode::onDown();
+        auto *player = NodeHandleTable::get().resolve(playerNode);
+        auto playerCollider = player ? player->getCollider() : rect<float>();
 
-        for (auto &child : children)
-            child->onDown();
+        bodies.classify(camera.GetScreenRect(), player ? &playerCollider : nullptr);
     }
 
-    void onLeft() override
+    /**
+     * Rebuilt from the game's own entries in the flattened tree, jumping over
+     * each one's subtree, whenever a node slept, woke, or the tree changed.
+     */
+    void refreshAwakeNodes()
     {
-        CoreNode::onLeft();
+        if (!awakeNodesDirty && !traversal.isStale())
+            return;
 
-        for (auto &child : children)
-            child->onLeft();
-    }
+        auto &nodes = traversal.get();
 
-    void onRight() override
-    {
-        CoreNode::onRight();
+        awakeNodes.clear();
+        for (size_t i = 1; i < nodes.size(); i += nodes[i].subtreeSize)
+            if (!nodes[i].node->sleeping)
+                awakeNodes.push_back(nodes[i].node);
 
-        for (auto &child : children)
-            child->onRight();
+        awakeNodesDirty = false;
     }
 
-    void onEnter() override
+    /**
+     * Drops everything the current level owns. Every child but the UI, which
+     * outlives levels, is released first so outstanding handles go stale
+     * before the nodes go back to their pools and the arena is reset. Only
+     * called outside of the update loop, at the sync point or from the menu
+     * and console.
+     */
+    void unloadLevel()
     {
-        CoreNode::onEnter();
+        recordCollected();
 
-        if (isPersistentDialogOpen())
+        auto &nodes = traversal.get();
+
+        // Index 0 is the game itself, which outlives levels like the UI
+        for (size_t i = 1; i < nodes.size();)
         {
-            popDialog();
-            return;
+            if (nodes[i].node == uiNode)
+            {
+                i += nodes[i].subtreeSize;
+                continue;
+            }
+
+            NodeHandleTable::get().release(nodes[i].node->getHandle());
+            i++;
         }
 
-        for (auto &child : children)
-            child->onEnter();
+        clearChildren();
+        playerNode = NodeHandle();
+
+        // Includes nodes destroyed during the level and collected items
+        for (auto *node : levelNodes)
+            ReleaseNode(node);
+
+        levelNodes.clear();
+
+        for (auto &state : spawnStates)
+            if (state.node != nullptr)
+                ReleaseNode(state.node);
+
+        spawnStates.clear();
+        spawnNodes.clear();
+        loadedChunks.clear();
+        loadedChunkList.clear();
+        scripts.clear();
+        flagWaiters.clear();
+        sleepers.clear();
+        bodies.clear();
+        awakeNodes.clear();
+        input.prune();
+        colliders.clear();
+        onScreenColliders.clear();
+        backgroundProvider = nullptr;
+        levelArena.reset();
+        currentLevel = NoLevel;
     }
 
-    void onGameOver()
+    /**
+     * Remembers which spawns of the current level are gone for good: taken
+     * or destroyed, not just streamed out. Carried items aren't, a loaded
+     * save puts them back in the level to be picked up again.
+     */
+    void recordCollected()
     {
-        isGameOver = true;
-    }
+        if (currentLevel == NoLevel || currentLevel >= collectedSpawns.size())
+            return;
 
-    std::vector<olc::utils::geom2d::rect<float> *> &getOnScreenColliders()
-    {
-        return onScreenColliders;
+        auto &collected = collectedSpawns[currentLevel];
+        collected.clear();
+
+        // Spawns that never had a node, like unknown entities, aren't taken
+        for (uint32_t i = 0; i < spawnStates.size(); i++)
+        {
+            auto &state = spawnStates[i];
+            bool taken = state.consumed || (!state.streamed && !spawnNodes[i].isNull());
+
+            if (taken && getSpawnSnapshot(i) == SpawnSnapshot::None)
+                collected.push_back(i);
+        }
     }
 
-    template <typename T>
-    T *getChild()
+    /**
+     * Sizes each entity pool for the busiest level, so no level load has to
+     * grow a pool.
+     */
+    void reserveNodePools()
     {
-        for (auto &child : children)
+        std::unordered_map<std::string, size_t> counts;
+
+        for (auto &level : world.levels)
         {
-            auto casted = dynamic_cast<T *>(child);
-            if (casted != nullptr)
-                return casted;
+            std::unordered_map<std::string, size_t> levelCounts;
+            for (auto &spawn : level.spawns)
+                levelCounts[spawn.identifier]++;
+
+            for (auto &[type, count] : levelCounts)
+                counts[type] = std::max(counts[type], count);
         }
 
-        return nullptr;
+        size_t total = 0;
+        for (auto &[type, count] : counts)
+        {
+            if (!ReserveNodes(type, count))
+            {
+                std::cerr << "No node type for entity '" << type << "'" << std::endl;
+                continue;
+            }
+
+            total += count;
+        }
+
+        levelNodes.reserve(total);
     }
 
-private:
     void updateOnScreenColliders()
     {
         onScreenColliders.clear();
@@ -869,20 +3297,35 @@ private:
     }
 };
 
+GameContext &CoreNode::getContext()
+{
+    return game->getContext();
+}
+
 #pragma endregion GameNode
 
 #pragma region Core Entity
 
 class EntityNode : public CoreNode
 {
+public:
+    /**
+     * Whether the level streams nodes of this class in and out as the camera
+     * moves. Classes whose state matters away from the camera opt out and
+     * live as long as the level.
+     */
+    static constexpr bool Streamed = true;
+    static constexpr bool Sleeps = true;
+
 protected:
-    const ldtk::Entity &entity;
     Camera *camera = nullptr;
     GameImageAssetProvider *spritesProvider = nullptr;
+    const EntitySpawn &spawn;
 
 public:
-    EntityNode(const ldtk::Entity &entity, GameNode *game) : CoreNode(entity.getName(), game), entity(entity)
+    EntityNode(const EntitySpawn &spawn, GameNode *game) : CoreNode(spawn.identifier, game), spawn(spawn)
     {
+        declareType<EntityNode>();
         if (game != nullptr)
         {
             camera = &game->camera;
@@ -892,28 +3335,43 @@ public:
 
     olc::vi2d getSpriteDrawPosition()
     {
-        auto &textureRect = entity.getTextureRect();
-        return olc::vi2d{textureRect.x, textureRect.y};
+        return spawn.spriteOffset;
     }
 
+    /**
+     * Nodes that may sleep get a body in the level's arrays. Nodes that move
+     * keep it where they stand in onUpdated, a frame behind at most.
+     */
     void onCreated() override
     {
         CoreNode::onCreated();
 
-        auto &entityPos = entity.getPosition();
-        position = {(float)entityPos.x, (float)entityPos.y};
+        position = spawn.position;
+
+        if (isSleepable() && game != nullptr)
+            body = game->getBodies().add(getHandle(), position, {SPRITE_SIZE, SPRITE_SIZE}, LevelBodies::Free | LevelBodies::Awake);
+    }
+
+    void onRestore(SnapshotReader &reader) override
+    {
+        CoreNode::onRestore(reader);
+
+        if (game != nullptr)
+            game->placeBody(this);
     }
 
     void onUpdated(float fElapsedTime) override
     {
         CoreNode::onUpdated(fElapsedTime);
-        if (DEBUG)
+        game->getBodies().place(body, position);
+
+        if (getContext().debug)
         {
             // Draw collider
             auto collider = getCollider();
             auto pos = collider.pos;
             game->camera.WorldToScreen(pos);
-            Rect(pos, collider.size, olc::RED);
+            getContext().Rect(pos, collider.size, olc::RED);
         }
     }
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+/**
+ * @brief EntityPrefab
+ * The setup every node of an entity type shares: its animation clips,
+ * sounds and collider size. Built once per world, the first time the type
+ * is created; nodes then copy the prefab's animator and point at the rest,
+ * so creating one doesn't allocate or load anything.
+ */
+struct EntityPrefab
+{
+    AnimationClips clips;
+    SpriteAnimator animator;
+    olc::vf2d colliderSize = {SPRITE_SIZE, SPRITE_SIZE};
+
+    virtual ~EntityPrefab() = default;
+
+    /**
+     * Loads a sound owned by the prefab, shared by all of its nodes.
+     */
+    Sound *loadSound(GameContext &context, const std::string &path, int channel = 0)
+    {
+        sounds.push_back(std::make_unique<Sound>(context, path, channel));
+        return sounds.back().get();
+    }
+
+private:
+    std::vector<std::unique_ptr<Sound>> sounds;
+};
+
+/**
+ * @brief PrefabTable
+ * A world's prefabs, one per node class, indexed by NodeTypeId.
+ */
+class PrefabTable
+{
+private:
+    std::array<std::unique_ptr<EntityPrefab>, NodeTypes::count> prefabs;
+
+public:
+    /**
+     * The prefab of type, made with build the first time it is asked for.
+     * Every node of a class has to ask for the same prefab type P.
+     */
+    template <typename P, typename Build>
+    const P &get(NodeTypeId type, Build &&build)
+    {
+        auto &prefab = prefabs[type];
+
+        if (!prefab)
+        {
+            auto made = std::make_unique<P>();
+            build(*made);
+            prefab = std::move(made);
+        }
+
+        return static_cast<const P &>(*prefab);
+    }
+};
@@ -1,44 +1,375 @@
 #pragma once
 
-class CoreNodeFactory
+/**
+ * @brief NodePool
+ * Fixed-size slots for one node type, allocated in contiguous chunks so
+ * nodes of the same type sit next to each other in memory. Released slots
+ * are reused by the next acquire, so reloading a level or starting a new
+ * game doesn't allocate once the pool has grown to fit.
+ */
+template <typename T>
+class NodePool
 {
-
 private:
-    std::unordered_map<std::string, std::function<CoreNode *(const ldtk::Entity &, GameNode *)>> registry;
+    struct Slot
+    {
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    std::vector<Slot *> freeSlots;
+    size_t capacity = 0;
 
 public:
-    static CoreNodeFactory &get()
+    void reserve(size_t count)
     {
-        static CoreNodeFactory instance;
-        return instance;
+        if (count > capacity)
+            grow(count - capacity);
     }
 
-    void registerNode(const std::string &type, std::function<CoreNode *(const ldtk::Entity &, GameNode *)> constructor)
+    template <typename... Args>
+    T *acquire(Args &&...args)
+    {
+        if (freeSlots.empty())
+            grow(std::max<size_t>(capacity, 8));
+
+        Slot *slot = freeSlots.back();
+        freeSlots.pop_back();
+        return CheckNodeType(new (slot->storage) T(std::forward<Args>(args)...));
+    }
+
+    void release(CoreNode *node)
+    {
+        T *object = static_cast<T *>(node);
+        object->~T();
+        freeSlots.push_back(reinterpret_cast<Slot *>(object));
+    }
+
+private:
+    void grow(size_t count)
+    {
+        chunks.push_back(std::make_unique<Slot[]>(count));
+        Slot *chunk = chunks.back().get();
+
+        // Pushed backwards so slots are handed out in address order
+        for (size_t i = count; i-- > 0;)
+            freeSlots.push_back(&chunk[i]);
+
+        capacity += count;
+    }
+};
+
+template <size_t N>
+struct FixedString
+{
+    char value[N];
+
+    constexpr FixedString(const char (&text)[N])
+    {
+        std::copy_n(text, N, value);
+    }
+
+    constexpr std::string_view view() const
+    {
+        return {value, N - 1};
+    }
+};
+
+/**
+ * Binds a node class to the LDtk entity identifier it is created for.
+ */
+template <typename T, FixedString Identifier>
+struct EntityType
+{
+    using Node = T;
+    static constexpr std::string_view identifier = Identifier.view();
+};
+
+/**
+ * @brief CoreNodeFactory
+ * Creates entity nodes from LDtk identifiers. The set of entity types is
+ * fixed at compile time: their identifiers are hashed into a perfect hash
+ * table while compiling, so resolving an identifier is one hash and one
+ * string compare, and creating the node is a jump through a table of
+ * functions that construct straight into the type's pool.
+ */
+template <typename... Entries>
+class CoreNodeFactory
+{
+private:
+    static constexpr size_t count = sizeof...(Entries);
+    static constexpr size_t tableSize = std::bit_ceil(count * 2);
+    static constexpr std::array<std::string_view, count> identifiers = {Entries::identifier...};
+
+    using Creator = CoreNode *(*)(CoreNodeFactory &, const EntitySpawn &, GameNode *);
+    using Releaser = void (*)(CoreNodeFactory &, CoreNode *);
+
+    std::tuple<NodePool<typename Entries::Node>...> pools;
+
+    static constexpr size_t slotOf(std::string_view identifier, uint32_t seed)
     {
-        registry[type] = constructor;
+        auto hash = HashKey(identifier, seed);
+        return (hash ^ (hash >> 16)) & (tableSize - 1);
     }
 
-    CoreNode *createNode(const std::string &type, const ldtk::Entity &entity, GameNode *game) const
+    static constexpr uint32_t findSeed()
     {
-        auto it = registry.find(type);
-        if (it != registry.end())
+        for (uint32_t seed = 2166136261u;; seed++)
         {
-            return it->second(entity, game);
+            std::array<bool, tableSize> used = {};
+            bool collides = false;
+
+            for (auto identifier : identifiers)
+            {
+                auto slot = slotOf(identifier, seed);
+                collides = collides || used[slot];
+                used[slot] = true;
+            }
+
+            if (!collides)
+                return seed;
         }
-        return nullptr;
+    }
+
+    static constexpr uint32_t seed = findSeed();
+
+    /**
+     * Entry index per hash slot, -1 for empty slots.
+     */
+    static constexpr auto buildTable()
+    {
+        std::array<int16_t, tableSize> table = {};
+        table.fill(-1);
+
+        for (size_t i = 0; i < count; i++)
+            table[slotOf(identifiers[i], seed)] = static_cast<int16_t>(i);
+
+        return table;
+    }
+
+    static constexpr auto table = buildTable();
+
+    /**
+     * Entry index per NodeTypeId, -1 for node classes that aren't entities.
+     */
+    static constexpr auto buildEntryOfType()
+    {
+        std::array<int16_t, NodeTypes::count> entries = {};
+        entries.fill(-1);
+
+        int16_t index = 0;
+        ((entries[NodeTypes::of<typename Entries::Node>()] = index++), ...);
+
+        return entries;
+    }
+
+    static constexpr auto entryOfType = buildEntryOfType();
+
+    static constexpr std::array<bool, count> streamed = {Entries::Node::Streamed...};
+
+    template <size_t I>
+    static CoreNode *create(CoreNodeFactory &factory, const EntitySpawn &spawn, GameNode *game)
+    {
+        return std::get<I>(factory.pools).acquire(spawn, game);
+    }
+
+    template <size_t I>
+    static void release(CoreNodeFactory &factory, CoreNode *node)
+    {
+        std::get<I>(factory.pools).release(node);
+    }
+
+    template <size_t... I>
+    static constexpr std::array<Creator, count> makeCreators(std::index_sequence<I...>)
+    {
+        return {&create<I>...};
+    }
+
+    template <size_t... I>
+    static constexpr std::array<Releaser, count> makeReleasers(std::index_sequence<I...>)
+    {
+        return {&release<I>...};
+    }
+
+    static constexpr auto creators = makeCreators(std::make_index_sequence<count>());
+    static constexpr auto releasers = makeReleasers(std::make_index_sequence<count>());
+
+    static int find(std::string_view identifier)
+    {
+        int index = table[slotOf(identifier, seed)];
+        return index >= 0 && identifiers[index] == identifier ? index : -1;
+    }
+
+public:
+    CoreNode *createNode(std::string_view type, const EntitySpawn &spawn, GameNode *game)
+    {
+        int index = find(type);
+        if (index < 0)
+            return nullptr;
+
+        return creators[index](*this, spawn, game);
+    }
+
+    /**
+     * Grows the pool behind an entity identifier to hold at least count
+     * nodes. Returns false for identifiers no node type is registered for.
+     */
+    bool reserve(std::string_view type, size_t count)
+    {
+        int index = find(type);
+        if (index < 0)
+            return false;
+
+        reserveAt(index, count, std::make_index_sequence<sizeof...(Entries)>());
+        return true;
+    }
+
+    /**
+     * Whether nodes of the identifier are streamed in and out with the camera
+     * rather than living for the whole level.
+     */
+    bool isStreamed(std::string_view type) const
+    {
+        int index = find(type);
+        return index >= 0 && streamed[index];
+    }
+
+    /**
+     * Destroys a node made by createNode and hands its slot back to its pool.
+     */
+    void releaseNode(CoreNode *node)
+    {
+        int index = entryOfType[node->getTypeId()];
+        if (index >= 0)
+            releasers[index](*this, node);
+    }
+
+private:
+    template <size_t... I>
+    void reserveAt(int index, size_t count, std::index_sequence<I...>)
+    {
+        ((static_cast<int>(I) == index ? std::get<I>(pools).reserve(count) : void()), ...);
     }
 };
 
-template <typename T>
-class NodeRegistrar
+/**
+ * Binds a minigame class to the name it is started by.
+ */
+template <typename T, FixedString Name>
+struct MiniGameType
+{
+    using Game = T;
+    static constexpr std::string_view name = Name.view();
+};
+
+/**
+ * @brief MiniGameRegistry
+ * Starts minigames by name. Instances aren't freed when a minigame ends,
+ * they wait in their type's pool and are handed out again, reset by
+ * onCreated, so playing again allocates nothing. Adding a minigame is
+ * adding its type to the registry's list.
+ */
+template <typename... Entries>
+class MiniGameRegistry
 {
+private:
+    static constexpr size_t count = sizeof...(Entries);
+    static constexpr std::array<std::string_view, count> names = {Entries::name...};
+
+    std::tuple<std::vector<std::unique_ptr<typename Entries::Game>>...> pools;
+
+    /**
+     * Entry index per NodeTypeId, -1 for node classes that aren't minigames.
+     */
+    static constexpr auto buildEntryOfType()
+    {
+        std::array<int16_t, NodeTypes::count> entries = {};
+        entries.fill(-1);
+
+        int16_t index = 0;
+        ((entries[NodeTypes::of<typename Entries::Game>()] = index++), ...);
+
+        return entries;
+    }
+
+    static constexpr auto entryOfType = buildEntryOfType();
+
+    static int find(std::string_view name)
+    {
+        for (size_t i = 0; i < count; i++)
+            if (names[i] == name)
+                return static_cast<int>(i);
+
+        return -1;
+    }
+
 public:
-    NodeRegistrar(const std::string &type)
+    /**
+     * A minigame of the given name for game, nullptr for names nothing is
+     * registered for.
+     */
+    MiniGame *acquire(std::string_view name, GameNode *game)
+    {
+        MiniGame *instance = nullptr;
+        acquireAt(find(name), game, instance, std::make_index_sequence<count>());
+        return instance;
+    }
+
+    /**
+     * Takes back a minigame from acquire. Its handles and its subtree's go
+     * stale, so timers and listeners of the game that ended never fire.
+     */
+    void release(MiniGame *instance)
+    {
+        int index = entryOfType[instance->getTypeId()];
+        if (index < 0)
+            return;
+
+        instance->release();
+        releaseAt(index, instance, std::make_index_sequence<count>());
+    }
+
+    /**
+     * Makes sure every minigame has an instance waiting.
+     */
+    void reserve()
     {
-        CoreNodeFactory::get().registerNode(type, [](const ldtk::Entity &entity, GameNode *game) -> CoreNode *
-                                        { return new T(entity, game); });
+        reserveAll(std::make_index_sequence<count>());
     }
-};
 
-#define REGISTER_NODE_TYPE(NODE_TYPE, STRING_ID) \
-    static NodeRegistrar<NODE_TYPE> reg_##NODE_TYPE(STRING_ID);
\ No newline at end of file
+private:
+    template <size_t I>
+    using GameAt = typename std::tuple_element_t<I, std::tuple<Entries...>>::Game;
+
+    template <size_t... I>
+    void acquireAt(int index, GameNode *game, MiniGame *&instance, std::index_sequence<I...>)
+    {
+        ((static_cast<int>(I) == index ? void(instance = take<I>(game)) : void()), ...);
+    }
+
+    template <size_t I>
+    MiniGame *take(GameNode *game)
+    {
+        auto &pool = std::get<I>(pools);
+        if (pool.empty())
+            return CheckNodeType(new GameAt<I>(game));
+
+        auto *instance = pool.back().release();
+        pool.pop_back();
+        instance->game = game;
+        instance->renew();
+        return instance;
+    }
+
+    template <size_t... I>
+    void releaseAt(int index, MiniGame *instance, std::index_sequence<I...>)
+    {
+        ((static_cast<int>(I) == index ? void(std::get<I>(pools).emplace_back(static_cast<GameAt<I> *>(instance))) : void()), ...);
+    }
+
+    template <size_t... I>
+    void reserveAll(std::index_sequence<I...>)
+    {
+        ((std::get<I>(pools).empty() ? void(std::get<I>(pools).emplace_back(new GameAt<I>(nullptr))) : void()), ...);
+    }
+};
@@ -0,0 +1,408 @@
+#pragma once
+
+#include <bit>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr const char *SaveGamePath = "save.dat";
+constexpr uint32_t SaveGameMagic = 0x43544651; // "QFTC"
+
+/**
+ * Bumped whenever the fields of a save change, older saves are then ignored
+ * instead of misread.
+ */
+constexpr uint32_t SaveGameVersion = 3;
+
+/**
+ * A save file starts with its magic, version, size and checksum, followed
+ * by size bytes of fields.
+ */
+constexpr size_t SaveGameHeaderSize = 4 * sizeof(uint32_t);
+
+uint32_t SaveGameChecksum(const std::byte *bytes, size_t size)
+{
+    return HashKey({reinterpret_cast<const char *>(bytes), size});
+}
+
+/**
+ * Every number in a save file is little endian, whatever the machine.
+ */
+void StoreSaveWord(std::byte *at, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        at[i] = static_cast<std::byte>(value >> (i * 8));
+}
+
+uint32_t LoadSaveWord(const std::byte *at)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value |= static_cast<uint32_t>(at[i]) << (i * 8);
+
+    return value;
+}
+
+/**
+ * @brief SaveDataWriter
+ * Appends the fields of a save to a buffer one at a time, in a fixed size
+ * and byte order, so a save reads the same on any machine or compiler.
+ * Unlike a snapshot nothing is copied as raw memory.
+ */
+class SaveDataWriter
+{
+private:
+    std::vector<std::byte> &bytes;
+
+public:
+    explicit SaveDataWriter(std::vector<std::byte> &bytes) : bytes(bytes)
+    {
+        bytes.clear();
+    }
+
+    void writeU8(uint8_t value)
+    {
+        bytes.push_back(static_cast<std::byte>(value));
+    }
+
+    void writeI8(int8_t value)
+    {
+        writeU8(static_cast<uint8_t>(value));
+    }
+
+    void writeU16(uint16_t value)
+    {
+        writeU8(static_cast<uint8_t>(value));
+        writeU8(static_cast<uint8_t>(value >> 8));
+    }
+
+    void writeU32(uint32_t value)
+    {
+        bytes.resize(bytes.size() + 4);
+        StoreSaveWord(bytes.data() + bytes.size() - 4, value);
+    }
+
+    void writeF32(float value)
+    {
+        writeU32(std::bit_cast<uint32_t>(value));
+    }
+
+    void writeString(const std::string &value)
+    {
+        auto length = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+        writeU16(length);
+        bytes.insert(bytes.end(), reinterpret_cast<const std::byte *>(value.data()), reinterpret_cast<const std::byte *>(value.data()) + length);
+    }
+};
+
+/**
+ * @brief SaveDataReader
+ * Reads back the fields of a save in the order SaveDataWriter wrote them.
+ * Reading past the end yields zeroes and marks the reader as failed.
+ */
+class SaveDataReader
+{
+private:
+    const std::byte *bytes;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+
+public:
+    SaveDataReader(const std::byte *bytes, size_t size) : bytes(bytes), size(size)
+    {
+    }
+
+    uint8_t readU8()
+    {
+        if (!has(1))
+            return 0;
+
+        return static_cast<uint8_t>(bytes[offset++]);
+    }
+
+    int8_t readI8()
+    {
+        return static_cast<int8_t>(readU8());
+    }
+
+    uint16_t readU16()
+    {
+        uint16_t low = readU8();
+        return static_cast<uint16_t>(low | readU8() << 8);
+    }
+
+    uint32_t readU32()
+    {
+        if (!has(4))
+            return 0;
+
+        offset += 4;
+        return LoadSaveWord(bytes + offset - 4);
+    }
+
+    float readF32()
+    {
+        return std::bit_cast<float>(readU32());
+    }
+
+    std::string readString()
+    {
+        auto length = readU16();
+        if (!has(length))
+            return {};
+
+        offset += length;
+        return std::string(reinterpret_cast<const char *>(bytes + offset - length), length);
+    }
+
+    bool hasFailed() const
+    {
+        return failed;
+    }
+
+private:
+    bool has(size_t count)
+    {
+        failed = failed || offset + count > size;
+        return !failed;
+    }
+};
+
+/**
+ * @brief SaveGameWriter
+ * Writes save files on a thread of its own, so the frame asking for a save
+ * never waits on the disk. Asking copies the fields into a buffer that
+ * was allocated up front; when saves come faster than the disk takes them
+ * only the latest is written. The file is written next to the save and
+ * renamed over it, so a crash mid-write leaves the previous save intact.
+ */
+class SaveGameWriter
+{
+private:
+    std::string path;
+    std::vector<std::byte> pending;
+    size_t pendingSize = 0;
+    bool hasPending = false;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+
+public:
+    explicit SaveGameWriter(const std::string &path, size_t capacity = 16 * 1024)
+        : path(path), pending(SaveGameHeaderSize + capacity)
+    {
+        worker = std::thread([this]()
+                             { run(); });
+    }
+
+    /**
+     * Writes what is still queued before returning.
+     */
+    ~SaveGameWriter()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+
+        wake.notify_one();
+        worker.join();
+    }
+
+    SaveGameWriter(const SaveGameWriter &) = delete;
+    SaveGameWriter &operator=(const SaveGameWriter &) = delete;
+
+    /**
+     * Queues the fields of a save, replacing whatever was queued before.
+     * Returns false if they don't fit the buffer.
+     */
+    bool submit(const std::vector<std::byte> &fields)
+    {
+        if (fields.empty())
+            return false;
+
+        {
+            std::lock_guard lock(mutex);
+
+            if (SaveGameHeaderSize + fields.size() > pending.size())
+                return false;
+
+            std::memcpy(pending.data() + SaveGameHeaderSize, fields.data(), fields.size());
+            pendingSize = fields.size();
+            hasPending = true;
+        }
+
+        wake.notify_one();
+        return true;
+    }
+
+private:
+    void run()
+    {
+        // Traded with pending, neither side allocates after construction
+        std::vector<std::byte> buffer(pending.size());
+        std::unique_lock lock(mutex);
+
+        while (true)
+        {
+            wake.wait(lock, [this]()
+                      { return hasPending || stopping; });
+
+            if (!hasPending)
+                return;
+
+            buffer.swap(pending);
+            size_t size = pendingSize;
+            hasPending = false;
+
+            lock.unlock();
+            write(buffer.data(), size);
+            lock.lock();
+        }
+    }
+
+    /**
+     * bytes holds room for the header followed by size bytes of fields.
+     */
+    void write(std::byte *bytes, size_t size)
+    {
+        StoreSaveWord(bytes, SaveGameMagic);
+        StoreSaveWord(bytes + 4, SaveGameVersion);
+        StoreSaveWord(bytes + 8, static_cast<uint32_t>(size));
+        StoreSaveWord(bytes + 12, SaveGameChecksum(bytes + SaveGameHeaderSize, size));
+
+        auto temporaryPath = path + ".tmp";
+        FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+        if (file == nullptr)
+        {
+            std::cerr << "Could not write save file '" << temporaryPath << "'" << std::endl;
+            return;
+        }
+
+        bool written = std::fwrite(bytes, 1, SaveGameHeaderSize + size, file) == SaveGameHeaderSize + size;
+        written = std::fflush(file) == 0 && written;
+
+#ifndef _WIN32
+        // On disk before it replaces the previous save
+        written = fsync(fileno(file)) == 0 && written;
+#endif
+
+        std::fclose(file);
+
+        std::error_code error;
+        if (written)
+            std::filesystem::rename(temporaryPath, path, error);
+
+        if (!written || error)
+            std::cerr << "Could not write save file '" << path << "'" << std::endl;
+    }
+};
+
+/**
+ * @brief MappedSaveGame
+ * A save file mapped into memory and checked against its header. The
+ * fields are read straight out of the mapping: nothing is parsed or copied
+ * up front.
+ */
+class MappedSaveGame
+{
+private:
+    const std::byte *bytes = nullptr;
+    size_t size = 0;
+    bool valid = false;
+
+#ifdef _WIN32
+    std::vector<std::byte> contents;
+#endif
+
+public:
+    explicit MappedSaveGame(const std::string &path)
+    {
+        map(path);
+
+        if (bytes == nullptr || size < SaveGameHeaderSize)
+            return;
+
+        valid = LoadSaveWord(bytes) == SaveGameMagic &&
+                LoadSaveWord(bytes + 4) == SaveGameVersion &&
+                LoadSaveWord(bytes + 8) == size - SaveGameHeaderSize &&
+                LoadSaveWord(bytes + 12) == SaveGameChecksum(bytes + SaveGameHeaderSize, size - SaveGameHeaderSize);
+    }
+
+    ~MappedSaveGame()
+    {
+#ifndef _WIN32
+        if (bytes != nullptr)
+            munmap(const_cast<std::byte *>(bytes), size);
+#endif
+    }
+
+    MappedSaveGame(const MappedSaveGame &) = delete;
+    MappedSaveGame &operator=(const MappedSaveGame &) = delete;
+
+    /**
+     * Whether the file exists, is of this version and isn't damaged.
+     */
+    bool isValid() const
+    {
+        return valid;
+    }
+
+    /**
+     * Reads the saved fields, only valid while the save is alive.
+     */
+    SaveDataReader getReader() const
+    {
+        if (!valid)
+            return SaveDataReader(nullptr, 0);
+
+        return SaveDataReader(bytes + SaveGameHeaderSize, size - SaveGameHeaderSize);
+    }
+
+private:
+    void map(const std::string &path)
+    {
+#ifdef _WIN32
+        // No mapping here, a save is small enough to read in one go
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return;
+
+        contents.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(contents.data()), contents.size());
+        bytes = contents.data();
+        size = contents.size();
+#else
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return;
+
+        struct stat status;
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            void *mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping != MAP_FAILED)
+            {
+                bytes = static_cast<const std::byte *>(mapping);
+                size = static_cast<size_t>(status.st_size);
+            }
+        }
+
+        // The mapping outlives the descriptor
+        close(descriptor);
+#endif
+    }
+};
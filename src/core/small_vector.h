@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+/**
+ * @brief SmallVector
+ * Vector of trivially copyable values with room for N of them inline. Up
+ * to N elements it never allocates and its data sits inside the owner;
+ * past that it moves to the heap like a std::vector.
+ */
+template <typename T, size_t N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector only holds trivially copyable values");
+
+private:
+    T inlineStorage[N];
+    T *items = inlineStorage;
+    size_t count = 0;
+    size_t capacity = N;
+
+public:
+    using value_type = T;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using reverse_iterator = std::reverse_iterator<T *>;
+    using const_reverse_iterator = std::reverse_iterator<const T *>;
+
+    SmallVector() = default;
+
+    SmallVector(const SmallVector &other)
+    {
+        *this = other;
+    }
+
+    SmallVector &operator=(const SmallVector &other)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        reserve(other.count);
+        std::memcpy(items, other.items, other.count * sizeof(T));
+        count = other.count;
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        if (items != inlineStorage)
+            delete[] items;
+    }
+
+    T *begin() { return items; }
+    T *end() { return items + count; }
+    const T *begin() const { return items; }
+    const T *end() const { return items + count; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T *data() { return items; }
+
+    T &operator[](size_t index) { return items[index]; }
+    const T &operator[](size_t index) const { return items[index]; }
+    T &front() { return items[0]; }
+    T &back() { return items[count - 1]; }
+
+    void reserve(size_t size)
+    {
+        if (size <= capacity)
+            return;
+
+        T *grown = new T[size];
+        std::memcpy(grown, items, count * sizeof(T));
+
+        if (items != inlineStorage)
+            delete[] items;
+
+        items = grown;
+        capacity = size;
+    }
+
+    void push_back(const T &value)
+    {
+        if (count == capacity)
+            reserve(capacity * 2);
+
+        items[count++] = value;
+    }
+
+    void pop_back()
+    {
+        count--;
+    }
+
+    T *insert(T *position, const T &value)
+    {
+        size_t index = position - items;
+
+        if (count == capacity)
+            reserve(capacity * 2);
+
+        std::memmove(items + index + 1, items + index, (count - index) * sizeof(T));
+        items[index] = value;
+        count++;
+        return items + index;
+    }
+
+    T *erase(T *first, T *last)
+    {
+        std::memmove(first, last, (end() - last) * sizeof(T));
+        count -= last - first;
+        return first;
+    }
+
+    T *erase(T *position)
+    {
+        return erase(position, position + 1);
+    }
+
+    void clear()
+    {
+        count = 0;
+    }
+};
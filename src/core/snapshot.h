@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief WorldSnapshot
+ * Buffer a world's mutable state is saved into. Its capacity is allocated
+ * once up front; saving only copies bytes into it and fails instead of
+ * growing when the world doesn't fit.
+ */
+class WorldSnapshot
+{
+private:
+    friend class SnapshotWriter;
+
+    std::vector<std::byte> buffer;
+    size_t size = 0;
+
+public:
+    explicit WorldSnapshot(size_t capacity = 64 * 1024) : buffer(capacity)
+    {
+    }
+
+    bool empty() const
+    {
+        return size == 0;
+    }
+
+    size_t getSize() const
+    {
+        return size;
+    }
+
+    const std::byte *data() const
+    {
+        return buffer.data();
+    }
+
+    void clear()
+    {
+        size = 0;
+    }
+};
+
+/**
+ * Appends values to a WorldSnapshot. Only trivially copyable values go in,
+ * as their raw bytes.
+ */
+class SnapshotWriter
+{
+private:
+    WorldSnapshot &snapshot;
+    size_t offset = 0;
+    bool overflowed = false;
+
+public:
+    explicit SnapshotWriter(WorldSnapshot &snapshot) : snapshot(snapshot)
+    {
+    }
+
+    template <typename T>
+    void write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written to a snapshot");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeString(const std::string &value)
+    {
+        auto length = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+        write(length);
+        writeBytes(value.data(), length);
+    }
+
+    void writeBytes(const void *bytes, size_t count)
+    {
+        if (overflowed || offset + count > snapshot.buffer.size())
+        {
+            overflowed = true;
+            return;
+        }
+
+        std::memcpy(snapshot.buffer.data() + offset, bytes, count);
+        offset += count;
+    }
+
+    /**
+     * Commits what was written. On overflow the snapshot is left empty.
+     */
+    bool finish()
+    {
+        snapshot.size = overflowed ? 0 : offset;
+        return !overflowed;
+    }
+};
+
+/**
+ * Reads values back from a WorldSnapshot, or bytes laid out like one, in
+ * the order they were written. Reading past the end yields zeroes and marks
+ * the reader as failed.
+ */
+class SnapshotReader
+{
+private:
+    const std::byte *bytes;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+
+public:
+    SnapshotReader(const std::byte *bytes, size_t size) : bytes(bytes), size(size)
+    {
+    }
+
+    explicit SnapshotReader(const WorldSnapshot &snapshot) : SnapshotReader(snapshot.data(), snapshot.getSize())
+    {
+    }
+
+    template <typename T>
+    void read(T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read from a snapshot");
+        readBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value{};
+        read(value);
+        return value;
+    }
+
+    void readString(std::string &value)
+    {
+        auto length = read<uint16_t>();
+
+        if (failed || offset + length > size)
+        {
+            failed = true;
+            value.clear();
+            return;
+        }
+
+        value.assign(reinterpret_cast<const char *>(bytes + offset), length);
+        offset += length;
+    }
+
+    void readBytes(void *destination, size_t count)
+    {
+        if (failed || offset + count > size)
+        {
+            failed = true;
+            std::memset(destination, 0, count);
+            return;
+        }
+
+        std::memcpy(destination, bytes + offset, count);
+        offset += count;
+    }
+
+    bool hasFailed() const
+    {
+        return failed;
+    }
+};
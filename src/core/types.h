@@ -0,0 +1,105 @@
+#pragma once
+
+class CoreNode;
+class EntityNode;
+class MiniGame;
+class GameNode;
+class MenuNode;
+class UINode;
+class PlayerNode;
+class Collectable;
+class TinyPurseNode;
+class BugSprayNode;
+class CoinNode;
+class FlowerNode;
+class PortalNode;
+class CheckPointNode;
+class GemNode;
+class GemCollectableNode;
+class ShellNode;
+class ShellGame;
+class CoreNPC;
+class AndersonNPC;
+class BeeEnemy;
+class ErikNPC;
+class MartinNPC;
+
+template <typename... Ts>
+struct TypeList
+{
+};
+
+template <typename T, typename List>
+struct TypeIndex;
+
+template <typename T, typename... Ts>
+struct TypeIndex<T, TypeList<T, Ts...>>
+{
+    static constexpr size_t value = 0;
+};
+
+template <typename T, typename U, typename... Ts>
+struct TypeIndex<T, TypeList<U, Ts...>>
+{
+    static constexpr size_t value = 1 + TypeIndex<T, TypeList<Ts...>>::value;
+};
+
+template <typename T>
+struct TypeIndex<T, TypeList<>>
+{
+    static_assert(sizeof(T) == 0, "Node class is missing from NodeTypeList in core/types.h");
+};
+
+template <typename List>
+struct TypeCount;
+
+template <typename... Ts>
+struct TypeCount<TypeList<Ts...>>
+{
+    static constexpr size_t value = sizeof...(Ts);
+};
+
+/**
+ * Every node class. A class's position in this list is its NodeTypeId.
+ */
+using NodeTypeList = TypeList<
+    CoreNode,
+    EntityNode,
+    MiniGame,
+    GameNode,
+    MenuNode,
+    UINode,
+    PlayerNode,
+    Collectable,
+    TinyPurseNode,
+    BugSprayNode,
+    CoinNode,
+    FlowerNode,
+    PortalNode,
+    CheckPointNode,
+    GemNode,
+    GemCollectableNode,
+    ShellNode,
+    ShellGame,
+    CoreNPC,
+    AndersonNPC,
+    BeeEnemy,
+    ErikNPC,
+    MartinNPC>;
+
+using NodeTypeId = uint16_t;
+
+/**
+ * Compile-time ids for node classes, so typed child lookups can go through
+ * an index instead of dynamic_cast.
+ */
+struct NodeTypes
+{
+    template <typename T>
+    static constexpr NodeTypeId of()
+    {
+        return static_cast<NodeTypeId>(TypeIndex<T, NodeTypeList>::value);
+    }
+
+    static constexpr NodeTypeId count = static_cast<NodeTypeId>(TypeCount<NodeTypeList>::value);
+};
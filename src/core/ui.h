@@ -1,19 +1,7 @@
 #pragma once
 
-struct GameImageAssetProvider
-{
-    olc::Decal *decal = nullptr;
-
-    GameImageAssetProvider(std::string path)
-    {
-        this->decal = new olc::Decal(new olc::Sprite(path));
-    }
-
-    ~GameImageAssetProvider()
-    {
-        delete decal;
-    }
-};
+struct GameImageAssetProvider;
+class SaveGameWriter;
 
 struct AssetOptions
 {
@@ -38,6 +26,243 @@ struct AssetOptions
     }
 };
 
+enum class YAlign
+{
+    TOP,
+    MIDDLE,
+    BOTTOM
+};
+
+enum class XAlign
+{
+    LEFT,
+    CENTER,
+    RIGHT
+};
+
+/**
+ * @brief GameRandom
+ * PCG32 generator (O'Neill's pcg32, XSH RR output). Its whole state is two
+ * words, so a snapshot saves it as is and restoring it is a plain copy.
+ */
+class GameRandom
+{
+public:
+    using result_type = uint32_t;
+
+    struct State
+    {
+        uint64_t state;
+        uint64_t increment;
+    };
+
+private:
+    State current{0, 1};
+
+public:
+    explicit GameRandom(uint32_t seed)
+    {
+        // The reference seeding, the stream picked by a fixed sequence
+        current.increment = (0xda3e39cb94b95bdbULL << 1) | 1;
+        step();
+        current.state += seed;
+        step();
+    }
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+
+    static constexpr result_type max()
+    {
+        return UINT32_MAX;
+    }
+
+    result_type operator()()
+    {
+        uint64_t old = current.state;
+        step();
+
+        auto xorShifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        auto rotation = static_cast<uint32_t>(old >> 59);
+        return (xorShifted >> rotation) | (xorShifted << ((-rotation) & 31));
+    }
+
+    const State &getState() const
+    {
+        return current;
+    }
+
+    void setState(const State &state)
+    {
+        // An even increment would collapse the sequence
+        current = {state.state, state.increment | 1};
+    }
+
+private:
+    void step()
+    {
+        current.state = current.state * 6364136223846793005ULL + current.increment;
+    }
+};
+
+/**
+ * @brief GameContext
+ * Everything a game world needs from outside of it: where it draws, where
+ * its input and audio come from, its random numbers and whether debug
+ * drawing is on. Each GameNode gets its own and passes it down to its
+ * nodes, so several worlds can run in one process.
+ *
+ * A context without a renderer is headless: drawing does nothing, keys are
+ * whatever setKey() says and sounds stay silent.
+ */
+class GameContext
+{
+private:
+    olc::PixelGameEngine *renderer = nullptr;
+    std::array<olc::HWButton, olc::Key::ENUM_END> keys = {};
+    olc::vi2d mousePosition;
+
+public:
+    olc::sound::WaveEngine *audio = nullptr;
+
+    /**
+     * Where checkpoints are saved to, none for worlds that don't persist.
+     */
+    SaveGameWriter *saves = nullptr;
+    GameRandom random;
+    bool debug = false;
+
+    GameContext(olc::PixelGameEngine *renderer = nullptr, olc::sound::WaveEngine *audio = nullptr, uint32_t seed = std::random_device{}())
+        : renderer(renderer), audio(audio), random(seed)
+    {
+    }
+
+    bool isHeadless() const
+    {
+        return renderer == nullptr;
+    }
+
+    /**
+     * Sets the state of a key for a headless context.
+     */
+    void setKey(olc::Key key, olc::HWButton state)
+    {
+        keys[key] = state;
+    }
+
+    /**
+     * Random integer in [0, max).
+     */
+    int randomInt(int max)
+    {
+        return max > 0 ? std::uniform_int_distribution<int>(0, max - 1)(random) : 0;
+    }
+
+    /**
+     * Random float in [0, 1).
+     */
+    float randomFloat()
+    {
+        return std::uniform_real_distribution<float>(0.0f, 1.0f)(random);
+    }
+
+    /**
+     * @brief Text
+     * Draw text on the screen.
+     *
+     * @param data Text to draw.
+     * @param color Color of the text.
+     * @param yAlign Vertical alignment.
+     * @param xAlign Horizontal alignment.
+     * @param scale Scale of the text.
+     * @param offset Offset of the text.
+     */
+    void Text(std::string data, olc::Pixel color = olc::WHITE, YAlign yAlign = YAlign::TOP, XAlign xAlign = XAlign::LEFT, olc::vf2d scale = {1, 1}, olc::vf2d offset = {0, 0});
+
+    /**
+     * @brief Text
+     * Draw text on the screen.
+     *
+     * @param data Text to draw.
+     * @param color Color of the text.
+     * @param position Position of the text.
+     * @param scale Scale of the text.
+     */
+    void Text(std::string data, olc::Pixel color, olc::vf2d position, olc::vf2d scale = {1, 1});
+
+    /**
+     * @brief TextSize
+     * Get the size of the text to be drawn.
+     */
+    olc::vi2d TextSize(std::string data);
+
+    void Image(GameImageAssetProvider *asset, AssetOptions *options = nullptr);
+
+    /**
+     * @brief Rect
+     * Draw a rectangle on the screen.
+     *
+     * @param position Position of the rectangle.
+     * @param size Size of the rectangle.
+     * @param color Color of the rectangle.
+     * @param filled Fill the rectangle.
+     */
+    void Rect(olc::vf2d position, olc::vf2d size, olc::Pixel color = olc::WHITE, bool filled = false);
+
+    /**
+     * Whether a key is pressed.
+     */
+    bool Pressed(olc::Key key);
+
+    /**
+     * Whether a key is pressed.
+     */
+    bool Pressed(int key);
+
+    /**
+     * Whether a key is held.
+     */
+    bool Held(olc::Key key);
+
+    /**
+     * Whether a key is released.
+     */
+    bool Released(olc::Key key);
+
+    /**
+     * @brief MousePosition
+     * Get the mouse position.
+     *
+     * @return const olc::vi2d&
+     */
+    const olc::vi2d &MousePosition();
+
+private:
+    olc::HWButton getKey(olc::Key key)
+    {
+        return renderer ? renderer->GetKey(key) : keys[key];
+    }
+};
+
+struct GameImageAssetProvider
+{
+    // The decal doesn't own its sprite, so it is declared after it to go first
+    std::unique_ptr<olc::Sprite> sprite;
+    std::unique_ptr<olc::Decal> decal;
+
+    GameImageAssetProvider(GameContext &context, std::string path)
+    {
+        // Headless worlds never draw, the texture would only cost a load
+        if (context.isHeadless())
+            return;
+
+        sprite = std::make_unique<olc::Sprite>(path);
+        decal = std::make_unique<olc::Decal>(sprite.get());
+    }
+};
+
 class AnimatedAssetProvider
 {
 
@@ -123,111 +348,160 @@ public:
     }
 };
 
-enum class YAlign
-{
-    TOP,
-    MIDDLE,
-    BOTTOM
-};
-
-enum class XAlign
-{
-    LEFT,
-    CENTER,
-    RIGHT
-};
-
 /**
- * @brief Text
- * Draw text on the screen.
- *
- * @param data Text to draw.
- * @param color Color of the text.
- * @param yAlign Vertical alignment.
- * @param xAlign Horizontal alignment.
- * @param scale Scale of the text.
- * @param offset Offset of the text.
+ * Index of a clip in an AnimationClips set.
  */
-void Text(std::string data, olc::Pixel color = olc::WHITE, YAlign yAlign = YAlign::TOP, XAlign xAlign = XAlign::LEFT, olc::vf2d scale = {1, 1}, olc::vf2d offset = {0, 0});
+using ClipId = uint8_t;
+constexpr ClipId NoClip = UINT8_MAX;
 
 /**
- * @brief Text
- * Draw text on the screen.
- *
- * @param data Text to draw.
- * @param color Color of the text.
- * @param position Position of the text.
- * @param scale Scale of the text.
+ * @brief AnimationClips
+ * Frames of a sprite's animations, built once and shared by everything
+ * drawn with them. Frames are cell offsets from the sprite's first cell.
  */
-void Text(std::string data, olc::Pixel color, olc::vf2d position, olc::vf2d scale = {1, 1});
+class AnimationClips
+{
+private:
+    struct Clip
+    {
+        uint16_t first;
+        uint16_t count;
+        float fps;
+    };
 
-/**
- * @brief TextSize
- * Get the size of the text to be drawn.
- */
-olc::vi2d TextSize(std::string data);
+    std::vector<olc::vf2d> frames;
+    std::vector<Clip> clips;
 
-void Image(GameImageAssetProvider *asset, AssetOptions *options = nullptr);
+public:
+    ClipId add(float fps, std::initializer_list<olc::vf2d> clipFrames)
+    {
+        clips.push_back({static_cast<uint16_t>(frames.size()), static_cast<uint16_t>(clipFrames.size()), fps});
+        frames.insert(frames.end(), clipFrames);
+        return static_cast<ClipId>(clips.size() - 1);
+    }
 
-/**
- * @brief Rect
- * Draw a rectangle on the screen.
- *
- * @param position Position of the rectangle.
- * @param size Size of the rectangle.
- * @param color Color of the rectangle.
- * @param filled Fill the rectangle.
- */
-void Rect(olc::vf2d position, olc::vf2d size, olc::Pixel color = olc::WHITE, bool filled = false);
+    uint16_t getFrameCount(ClipId clip) const
+    {
+        return clips[clip].count;
+    }
 
-/**
- * Whether a key is pressed.
- */
-bool Pressed(olc::Key key);
+    float getFps(ClipId clip) const
+    {
+        return clips[clip].fps;
+    }
 
-/**
- * Whether a key is pressed.
- */
-bool Pressed(int key);
+    olc::vf2d getFrame(ClipId clip, uint16_t frame) const
+    {
+        return frames[clips[clip].first + frame];
+    }
+};
 
 /**
- * Whether a key is held.
+ * @brief SpriteAnimator
+ * Plays clips from a shared AnimationClips set. Holds no resources of its
+ * own, copying one is a plain copy of a few bytes.
  */
-bool Held(olc::Key key);
+class SpriteAnimator
+{
+private:
+    const AnimationClips *clips = nullptr;
+    AssetOptions options;
+    olc::vf2d initialOffset;
+    ClipId clip = NoClip;
+    float elapsedTime = 0;
 
-/**
- * Whether a key is released.
- */
-bool Released(olc::Key key);
+public:
+    SpriteAnimator() = default;
+
+    SpriteAnimator(const AnimationClips *clips, olc::vf2d initialOffset, olc::vf2d size = {SPRITE_SIZE, SPRITE_SIZE})
+        : clips(clips), options({0, 0}, initialOffset, {1, 1}, size), initialOffset(initialOffset)
+    {
+    }
+
+    void Play(ClipId clip, bool reset = true)
+    {
+        this->clip = clip;
+        if (reset)
+            elapsedTime = 0;
+    }
+
+    void setOffset(olc::vf2d offset)
+    {
+        initialOffset = offset;
+        options.offset = offset;
+    }
+
+    void setTint(olc::Pixel tint)
+    {
+        options.tint = tint;
+    }
+
+    void Update(float fElapsedTime)
+    {
+        if (clip == NoClip)
+            return;
+
+        elapsedTime += fElapsedTime;
+
+        if (elapsedTime * clips->getFps(clip) >= clips->getFrameCount(clip))
+            elapsedTime = 0;
+    }
+
+    AssetOptions *GetAssetOptions()
+    {
+        if (clip == NoClip)
+            return &options;
+
+        auto frame = clips->getFrame(clip, static_cast<uint16_t>(elapsedTime * clips->getFps(clip)));
+        options.offset = initialOffset + frame * options.size;
+
+        return &options;
+    }
+};
 
 /**
- * @brief MousePosition
- * Get the mouse position.
- *
- * @return const olc::vi2d&
+ * Size of text in the engine's 8x8 font, the same GetTextSize gives without
+ * needing a renderer.
  */
-const olc::vi2d &MousePosition();
+olc::vi2d MeasureText(const std::string &text)
+{
+    olc::vi2d size = {0, 1};
+    int column = 0;
 
-#ifdef USE_PIXEL_GAME_ENGINE
+    for (char c : text)
+    {
+        if (c == '\n')
+        {
+            size.y++;
+            column = 0;
+            continue;
+        }
 
-olc::PixelGameEngine *ctx = nullptr;
+        size.x = std::max(size.x, ++column);
+    }
 
-void SetContext(olc::PixelGameEngine *pge)
-{
-    ctx = pge;
+    return size * 8;
 }
 
-olc::vi2d TextSize(std::string data)
+#ifdef USE_PIXEL_GAME_ENGINE
+
+olc::vi2d GameContext::TextSize(std::string data)
 {
-    return ctx->GetTextSize(data);
+    if (renderer)
+        return renderer->GetTextSize(data);
+
+    return MeasureText(data);
 }
 
-void Text(std::string data, olc::Pixel color, YAlign yAlign, XAlign xAlign, olc::vf2d scale, olc::vf2d offset)
+void GameContext::Text(std::string data, olc::Pixel color, YAlign yAlign, XAlign xAlign, olc::vf2d scale, olc::vf2d offset)
 {
+    if (!renderer)
+        return;
+
     float_t x = 0;
     float_t y = 0;
-    auto screenSize = ctx->GetScreenSize();
-    auto textSize = ctx->GetTextSize(data) * scale;
+    auto screenSize = renderer->GetScreenSize();
+    auto textSize = renderer->GetTextSize(data) * scale;
 
     switch (yAlign)
     {
@@ -258,27 +532,31 @@ void Text(std::string data, olc::Pixel color, YAlign yAlign, XAlign xAlign, olc:
     x += offset.x;
     y += offset.y;
 
-    ctx->DrawStringDecal({x, y}, data, color, scale);
+    renderer->DrawStringDecal({x, y}, data, color, scale);
 }
 
-void Text(std::string data, olc::Pixel color, olc::vf2d position, olc::vf2d scale)
+void GameContext::Text(std::string data, olc::Pixel color, olc::vf2d position, olc::vf2d scale)
 {
-    ctx->DrawStringDecal(position, data, color, scale);
+    if (renderer)
+        renderer->DrawStringDecal(position, data, color, scale);
 }
 
-void Image(GameImageAssetProvider *asset, AssetOptions *option)
+void GameContext::Image(GameImageAssetProvider *asset, AssetOptions *option)
 {
+    if (!renderer)
+        return;
+
     if (!asset || !asset->decal)
     {
         throw std::runtime_error("Asset or Decal is null");
         return;
     }
 
-    olc::Decal *decal = asset->decal;
+    olc::Decal *decal = asset->decal.get();
 
     if (!option)
     {
-        ctx->DrawDecal({0, 0}, decal, {1, 1});
+        renderer->DrawDecal({0, 0}, decal, {1, 1});
         return;
     }
 
@@ -287,45 +565,48 @@ void Image(GameImageAssetProvider *asset, AssetOptions *option)
     auto offset = option->offset;
     auto size = option->size;
 
-    ctx->DrawPartialDecal(position, decal, offset, size, scale, option->tint);
+    renderer->DrawPartialDecal(position, decal, offset, size, scale, option->tint);
 }
 
-void Rect(olc::vf2d position, olc::vf2d size, olc::Pixel color, bool filled)
+void GameContext::Rect(olc::vf2d position, olc::vf2d size, olc::Pixel color, bool filled)
 {
+    if (!renderer)
+        return;
+
     if (filled)
     {
-        ctx->FillRectDecal(position, size, color);
+        renderer->FillRectDecal(position, size, color);
     }
     else
     {
-        ctx->DrawRectDecal(position, size, color);
+        renderer->DrawRectDecal(position, size, color);
     }
 }
 
-bool Pressed(olc::Key key)
+bool GameContext::Pressed(olc::Key key)
 {
-    return ctx->GetKey(key).bPressed;
+    return getKey(key).bPressed;
 }
 
-bool Pressed(int key)
+bool GameContext::Pressed(int key)
 {
     auto keyNumber = static_cast<olc::Key>(key);
-    return ctx->GetKey(keyNumber).bPressed;
+    return getKey(keyNumber).bPressed;
 }
 
-bool Held(olc::Key key)
+bool GameContext::Held(olc::Key key)
 {
-    return ctx->GetKey(key).bHeld;
+    return getKey(key).bHeld;
 }
 
-bool Released(olc::Key key)
+bool GameContext::Released(olc::Key key)
 {
-    return ctx->GetKey(key).bReleased;
+    return getKey(key).bReleased;
 }
 
-const olc::vi2d &MousePosition()
+const olc::vi2d &GameContext::MousePosition()
 {
-    return ctx->GetMousePos();
+    return renderer ? renderer->GetMousePos() : mousePosition;
 }
 
 #endif
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <variant>
+
+/**
+ * Decoded "bee" fields. travel is in grid cells, as authored in LDtk.
+ */
+struct BeeFields
+{
+    olc::vi2d travel;
+    bool hasTravel = false;
+    bool isMad = false;
+};
+
+constexpr uint16_t NoLevel = UINT16_MAX;
+
+/**
+ * Decoded "portal" fields. targetLevel indexes WorldData::levels.
+ */
+struct PortalFields
+{
+    bool enabled = false;
+    uint16_t targetLevel = NoLevel;
+};
+
+/**
+ * Decoded "purse" fields.
+ */
+struct PurseFields
+{
+    uint8_t slots = 2;
+};
+
+using EntityFields = std::variant<std::monostate, BeeFields, PortalFields, PurseFields>;
+
+/**
+ * @brief EntitySpawn
+ * One entity of a level, decoded once when the world is loaded. Nodes are
+ * constructed from it and never see the LDtk project.
+ */
+struct EntitySpawn
+{
+    std::string identifier;
+    olc::vf2d position;
+    olc::vi2d spriteOffset;
+    EntityFields fields;
+
+    /**
+     * Cleared to keep a spawn of a streamed type loaded with its level.
+     */
+    bool streamable = true;
+
+    /**
+     * The decoded fields of this entity, or defaults when it has none of T.
+     */
+    template <typename T>
+    const T &getFields() const
+    {
+        if (auto *decoded = std::get_if<T>(&fields))
+            return *decoded;
+
+        static const T defaults;
+        return defaults;
+    }
+};
+
+struct TileData
+{
+    olc::vf2d position;
+    olc::vf2d textureOffset;
+    olc::vf2d size;
+};
+
+/**
+ * Side of the square chunks spawns are streamed in by.
+ */
+constexpr float SpawnChunkSize = 512.0f;
+
+struct LevelData
+{
+    std::string name;
+    std::string backgroundPath;
+    olc::vi2d size;
+    std::vector<olc::utils::geom2d::rect<float>> colliders;
+    std::vector<TileData> tiles;
+    std::vector<EntitySpawn> spawns;
+
+    /**
+     * Indices into spawns, per chunk, row by row.
+     */
+    std::vector<std::vector<uint32_t>> chunks;
+    olc::vi2d chunkCount;
+
+    olc::vi2d chunkOf(olc::vf2d position) const
+    {
+        return {std::clamp(static_cast<int>(position.x / SpawnChunkSize), 0, chunkCount.x - 1),
+                std::clamp(static_cast<int>(position.y / SpawnChunkSize), 0, chunkCount.y - 1)};
+    }
+
+    int chunkIndex(olc::vi2d chunk) const
+    {
+        return chunk.y * chunkCount.x + chunk.x;
+    }
+};
+
+/**
+ * @brief WorldData
+ * The parts of the LDtk project the game uses, baked into flat structs. The
+ * project itself only lives for the duration of load().
+ */
+class WorldData
+{
+private:
+    static constexpr const char *IconNames[] = {"base", "spray", "purse", "slot", "checkpoint", "portal", "shell", "gem"};
+
+    std::unordered_map<std::string, olc::vi2d> icons;
+
+public:
+    std::vector<LevelData> levels;
+
+    void load(const std::string &path)
+    {
+        ldtk::Project project;
+        project.loadFromFile(path);
+        auto &world = project.getWorld();
+
+        levels.clear();
+        icons.clear();
+
+        // Levels first, portals refer to them by index
+        for (auto &level : world.allLevels())
+        {
+            LevelData data;
+            data.name = level.name;
+            levels.push_back(std::move(data));
+        }
+
+        for (size_t i = 0; i < levels.size(); i++)
+            bakeLevel(world.getLevel(levels[i].name), levels[i]);
+
+        auto &iconEnum = world.getEnum("world");
+        for (auto *name : IconNames)
+        {
+            auto &textureRect = iconEnum[name].getIconTextureRect();
+            icons[name] = {textureRect.x, textureRect.y};
+        }
+    }
+
+    uint16_t findLevel(const std::string &name) const
+    {
+        for (size_t i = 0; i < levels.size(); i++)
+            if (levels[i].name == name)
+                return static_cast<uint16_t>(i);
+
+        return NoLevel;
+    }
+
+    /**
+     * Adds a copy of the level base with count coins scattered over it, for
+     * benchmarking worlds far more crowded than any level in the project.
+     * The coins aren't streamed, so every one of them is a node that the
+     * per-frame loops walk or put to sleep. Returns the new level's index.
+     */
+    uint16_t addCrowdedLevel(uint16_t base, size_t count, std::mt19937 &random)
+    {
+        EntitySpawn coin;
+        coin.identifier = "coin";
+        coin.streamable = false;
+
+        for (auto &level : levels)
+            for (auto &spawn : level.spawns)
+                if (spawn.identifier == "coin")
+                    coin.spriteOffset = spawn.spriteOffset;
+
+        LevelData level = levels[base];
+        level.name += "_crowded_" + std::to_string(count);
+
+        std::uniform_real_distribution<float> x(0.0f, std::max(0, level.size.x - SPRITE_SIZE));
+        std::uniform_real_distribution<float> y(0.0f, std::max(0, level.size.y - SPRITE_SIZE));
+        level.spawns.reserve(level.spawns.size() + count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            coin.position = {x(random), y(random)};
+            level.spawns.push_back(coin);
+        }
+
+        for (auto &chunk : level.chunks)
+            chunk.clear();
+
+        for (uint32_t i = 0; i < level.spawns.size(); i++)
+            level.chunks[level.chunkIndex(level.chunkOf(level.spawns[i].position))].push_back(i);
+
+        levels.push_back(std::move(level));
+        return static_cast<uint16_t>(levels.size() - 1);
+    }
+
+    /**
+     * Sprite sheet position of a "world" enum icon.
+     */
+    olc::vi2d getIcon(const std::string &name) const
+    {
+        auto it = icons.find(name);
+        return it != icons.end() ? it->second : olc::vi2d{0, 0};
+    }
+
+private:
+    void bakeLevel(const ldtk::Level &level, LevelData &data)
+    {
+        data.backgroundPath = "assets/map_project/" + std::string(level.getBgImage().path.c_str());
+        data.size = {level.size.x, level.size.y};
+
+        auto &collidersLayer = level.getLayer("colliders");
+        auto offset = collidersLayer.getOffset();
+        float cellSize = static_cast<float>(collidersLayer.getCellSize());
+
+        for (int x = 0; x < collidersLayer.getGridSize().x; x++)
+        {
+            for (int y = 0; y < collidersLayer.getGridSize().y; y++)
+            {
+                if (collidersLayer.getIntGridVal(x, y).value <= 0)
+                    continue;
+
+                olc::vf2d pos = {x * cellSize + offset.x, y * cellSize + offset.y};
+                data.colliders.push_back({pos, {cellSize, cellSize}});
+            }
+        }
+
+        for (auto &tile : level.getLayer("platform").allTiles())
+        {
+            auto rect = tile.getTextureRect();
+            auto pos = tile.getPosition();
+            data.tiles.push_back({{static_cast<float>(pos.x), static_cast<float>(pos.y)},
+                                  {static_cast<float>(rect.x), static_cast<float>(rect.y)},
+                                  {static_cast<float>(rect.width), static_cast<float>(rect.height)}});
+        }
+
+        auto &entities = level.getLayer("entities").allEntities();
+        data.spawns.reserve(entities.size());
+
+        for (auto &entity : entities)
+        {
+            auto &pos = entity.getPosition();
+            auto &textureRect = entity.getTextureRect();
+
+            EntitySpawn spawn;
+            spawn.identifier = entity.getName();
+            spawn.position = {static_cast<float>(pos.x), static_cast<float>(pos.y)};
+            spawn.spriteOffset = {textureRect.x, textureRect.y};
+            spawn.fields = decodeFields(entity);
+            data.spawns.push_back(std::move(spawn));
+        }
+
+        data.chunkCount = {std::max(1, static_cast<int>(std::ceil(data.size.x / SpawnChunkSize))),
+                           std::max(1, static_cast<int>(std::ceil(data.size.y / SpawnChunkSize)))};
+        data.chunks.resize(data.chunkCount.x * data.chunkCount.y);
+
+        for (uint32_t i = 0; i < data.spawns.size(); i++)
+            data.chunks[data.chunkIndex(data.chunkOf(data.spawns[i].position))].push_back(i);
+    }
+
+    EntityFields decodeFields(const ldtk::Entity &entity) const
+    {
+        auto &identifier = entity.getName();
+
+        if (identifier == "bee")
+        {
+            BeeFields fields;
+            auto &travel = entity.getField<ldtk::FieldType::Point>("travel");
+            auto &isMad = entity.getField<ldtk::FieldType::Bool>("is_mad");
+
+            if (!travel.is_null())
+            {
+                fields.travel = {travel.value().x, travel.value().y};
+                fields.hasTravel = true;
+            }
+
+            fields.isMad = !isMad.is_null() && isMad.value();
+            return fields;
+        }
+
+        if (identifier == "portal")
+        {
+            PortalFields fields;
+            fields.enabled = entity.getField<ldtk::FieldType::Bool>("enabled").value_or(false);
+            fields.targetLevel = findLevel(entity.getField<ldtk::FieldType::String>("level").value_or(""));
+            return fields;
+        }
+
+        if (identifier == "purse")
+        {
+            PurseFields fields;
+            auto &slots = entity.getField<ldtk::FieldType::Int>("slots");
+
+            if (!slots.is_null())
+                fields.slots = static_cast<uint8_t>(slots.value());
+
+            return fields;
+        }
+
+        return std::monostate();
+    }
+};
@@ -9,8 +9,17 @@
 
 #include <cassert>
 #include <random>
-#include <stack>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <bit>
+#include <tuple>
+#include <coroutine>
+#include <utility>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <typeinfo>
 #include <olcUTIL_Geometry2D.h>
 #include <olcPixelGameEngine.h>
 #include <LDtkLoader/Project.hpp>
@@ -18,8 +27,20 @@
 olc::Key static const LEFT_KEY = olc::Key::LEFT;
 olc::Key static const RIGHT_KEY = olc::Key::RIGHT;
 
-#include "core/audio.h"
 #include "core/ui.h"
+#include "core/audio.h"
+#include "core/types.h"
+#include "core/small_vector.h"
+#include "core/handles.h"
+#include "core/arena.h"
+#include "core/activity.h"
+#include "core/bodies.h"
+#include "core/flags.h"
+#include "core/dialogs.h"
+#include "core/world.h"
+#include "core/snapshot.h"
+#include "core/savegame.h"
+#include "core/prefabs.h"
 #include "core/nodes.h"
 #include "registry.h"
 #include "menu.cc"
@@ -28,16 +49,77 @@ olc::Key static const RIGHT_KEY = olc::Key::RIGHT;
 #include "collectables.cc"
 #include "minigames.cc"
 #include "ui.cc"
+#include "batch.cc"
+
+using EntityFactory = CoreNodeFactory<
+    EntityType<PlayerNode, "player">,
+    EntityType<TinyPurseNode, "purse">,
+    EntityType<BugSprayNode, "bug_spray">,
+    EntityType<CoinNode, "coin">,
+    EntityType<FlowerNode, "flower">,
+    EntityType<PortalNode, "portal">,
+    EntityType<CheckPointNode, "checkpoint">,
+    EntityType<GemCollectableNode, "gem">,
+    EntityType<AndersonNPC, "anderson">,
+    EntityType<BeeEnemy, "bee">,
+    EntityType<ErikNPC, "erik">,
+    EntityType<MartinNPC, "martin">>;
+
+/**
+ * Pools are per thread, nodes are only ever handed out to worlds on it.
+ */
+EntityFactory &GetEntityFactory()
+{
+    static thread_local EntityFactory factory;
+    return factory;
+}
+
+CoreNode *CreateNode(GameNode *game, const EntitySpawn &spawn)
+{
+    return GetEntityFactory().createNode(spawn.identifier, spawn, game);
+}
+
+void ReleaseNode(CoreNode *node)
+{
+    GetEntityFactory().releaseNode(node);
+}
+
+bool ReserveNodes(const std::string &type, size_t count)
+{
+    return GetEntityFactory().reserve(type, count);
+}
+
+bool IsStreamedNode(const std::string &type)
+{
+    return GetEntityFactory().isStreamed(type);
+}
+
+using MiniGames = MiniGameRegistry<
+    MiniGameType<ShellGame, "ShellGame">>;
 
-CoreNode *CreateNode(GameNode *game, const ldtk::Entity &entity)
+/**
+ * Per thread like the entity pools, minigames are only reused on the thread
+ * that made them.
+ */
+MiniGames &GetMiniGames()
 {
-    auto type = entity.getName();
-    return CoreNodeFactory::get().createNode(type, entity, game);
+    static thread_local MiniGames registry;
+    return registry;
 }
 
 MiniGame *CreateMiniGame(const std::string &name, GameNode *game)
 {
-    return new ShellGame(game);
+    return GetMiniGames().acquire(name, game);
+}
+
+void ReleaseMiniGame(MiniGame *game)
+{
+    GetMiniGames().release(game);
+}
+
+void ReserveMiniGames()
+{
+    GetMiniGames().reserve();
 }
 
 class QuestForTrueColor : public olc::PixelGameEngine
@@ -46,7 +128,11 @@ private:
     GameNode *gameNode = nullptr;
     MenuNode *menuNode = nullptr;
     olc::sound::WaveEngine soundEngine;
-    Sound gameSound = Sound("assets/sfx/huperboloid.wav");
+    GameContext context{this, &soundEngine};
+    Sound gameSound{context, "assets/sfx/huperboloid.wav"};
+    GameData data;
+    SaveGameWriter saves{SaveGamePath};
+    WorldSnapshot rewindSnapshot;
     bool paused = true;
     bool didSkipFrame = false;
 
@@ -76,7 +162,7 @@ public:
         // Flip debug mode
         if (sCommand == "debug")
         {
-            DEBUG = !DEBUG;
+            context.debug = !context.debug;
             return true;
         }
 
@@ -90,6 +176,52 @@ public:
             return true;
         }
 
+        // Toggle a game flag by name
+        if (sCommand == "flag" || sCommand.find("flag ") == 0)
+        {
+            auto flag = sCommand.size() > 5 ? FindFlag(sCommand.substr(5)) : GameFlag::Count;
+            if (flag == GameFlag::Count)
+            {
+                ConsoleOut() << "usage: flag <name>, one of:";
+                for (auto name : GameFlagNames)
+                    ConsoleOut() << " " << name;
+
+                ConsoleOut() << "\n";
+                return true;
+            }
+
+            gameNode->setFlag(flag, !gameNode->getFlag(flag));
+            return true;
+        }
+
+        // Slow motion, 1 is normal speed and 0 freezes the game clock
+        if (sCommand.find("timescale ") == 0)
+        {
+            gameNode->getTimers().setTimeScale(std::strtof(sCommand.c_str() + 10, nullptr));
+            return true;
+        }
+
+        // Print how long each update phase took last frame
+        if (sCommand == "phases")
+        {
+            auto &scheduler = gameNode->getScheduler();
+            for (size_t i = 0; i < static_cast<size_t>(UpdatePhase::Count); i++)
+                ConsoleOut() << UpdatePhaseNames[i] << ": " << scheduler.getMilliseconds(static_cast<UpdatePhase>(i)) << "ms\n";
+
+            return true;
+        }
+
+        // Save the world to rewind to later, timing both ways
+        if (sCommand == "snapshot" || sCommand == "rewind")
+        {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = sCommand == "snapshot" ? gameNode->saveSnapshot(rewindSnapshot) : gameNode->restoreSnapshot(rewindSnapshot);
+            auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            ConsoleOut() << sCommand << (ok ? "" : " failed") << ": " << rewindSnapshot.getSize() << " bytes, " << elapsed << "us\n";
+            return true;
+        }
+
         if (sCommand.find("minigame") == 0)
         {
             auto minigame = sCommand.substr(9);
@@ -102,20 +234,24 @@ public:
 
     bool OnUserCreate() override
     {
-        SetContext(this);
         paused = true;
 
-        auto *uiNode = new UINode(nullptr);
-        menuNode = new MenuNode();
-        gameNode = new GameNode(uiNode);
+        data.load();
+
+        auto *uiNode = CheckNodeType(new UINode(nullptr));
+        menuNode = CheckNodeType(new MenuNode());
+        gameNode = CheckNodeType(new GameNode(context, uiNode, data));
         uiNode->game = gameNode;
 
         menuNode->game = gameNode;
         gameNode->onCreated();
         menuNode->onCreated();
 
+        // Continue is only offered when there is a save to continue from
+        menuNode->canContinue = gameNode->loadGame(SaveGamePath);
+        context.saves = &saves;
+
         soundEngine.InitialiseAudio();
-        setSoundEngine(&soundEngine);
 
         return true;
     }
@@ -189,19 +325,19 @@ public:
             gameSound.Play(true, false);
 
             if (upState.bHeld)
-                gameNode->onUp();
+                gameNode->handleInput(InputAction::Up);
 
             if (downState.bHeld)
-                gameNode->onDown();
+                gameNode->handleInput(InputAction::Down);
 
             if (leftState.bHeld)
-                gameNode->onLeft();
+                gameNode->handleInput(InputAction::Left);
 
             if (rightState.bHeld)
-                gameNode->onRight();
+                gameNode->handleInput(InputAction::Right);
 
             if (enterState.bPressed)
-                gameNode->onEnter();
+                gameNode->handleInput(InputAction::Enter);
 
             gameNode->onUpdated(fElapsedTime);
         }
@@ -12,6 +12,7 @@ public:
 
     MenuNode() : CoreNode("menu", nullptr)
     {
+        declareType<MenuNode>();
     }
 
     bool canContinueGame()
@@ -21,7 +22,7 @@ public:
 
     void onCreated()
     {
-        spritesProvider = new GameImageAssetProvider("assets/sprite_project/Sprites.png");
+        spritesProvider = new GameImageAssetProvider(getContext(), "assets/sprite_project/Sprites.png");
         options = new AssetOptions({0, 0}, {0, 0});
     }
 
@@ -42,17 +43,17 @@ public:
         // interpolate the value so we can get a value between 0.6 and 1.0
         auto value = 0.6 + 0.4 * deltaTime / 0.2;
 
-        auto topPadding = menuOptions.size() * TextSize("A") * scale;
+        auto topPadding = menuOptions.size() * getContext().TextSize("A") * scale;
 
         for (int i = 0; i < menuOptions.size(); i++)
         {
             bool isSelected = menuOptions[i] == selectedOption;
-            auto textSize = TextSize(menuOptions[i]) * scale;
+            auto textSize = getContext().TextSize(menuOptions[i]) * scale;
             auto offset = olc::vf2d{0, 0};
             offset.y = i * textSize.y - topPadding.y * 0.5f;
             olc::Pixel color = isSelected ? olc::YELLOW : olc::WHITE;
 
-            Text(menuOptions[i], color, YAlign::MIDDLE, XAlign::CENTER, scale * (isSelected ? 1.0 * value : 0.6), offset);
+            getContext().Text(menuOptions[i], color, YAlign::MIDDLE, XAlign::CENTER, scale * (isSelected ? 1.0 * value : 0.6), offset);
         }
     }
 
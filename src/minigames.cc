@@ -4,22 +4,47 @@ private:
     const uint8_t shellCount = 3;
     bool didMove = false;
     bool didDisplayShell = false;
-    float moveTime = 0.0f;
+    bool isScrambling = false;
+    NameId shellNames[3] = {};
+
+    // Kept for every round, the game is pooled and played again
+    ShellNode *shells[3] = {};
+    GemNode *gem = nullptr;
 
 public:
     ShellGame(GameNode *game) : MiniGame("ShellGame", game)
     {
+        declareType<ShellGame>();
+
+        for (int i = 0; i < shellCount; i++)
+        {
+            shells[i] = new ShellNode(game);
+            shells[i]->setName("shell_" + std::to_string(i + 1));
+            shellNames[i] = NodeNames::intern("shell_" + std::to_string(i + 1));
+        }
+
+        gem = new GemNode(game);
+    }
+
+    ~ShellGame()
+    {
+        for (auto *shell : shells)
+            delete shell;
+
+        delete gem;
     }
 
     void onCreated() override
     {
         MiniGame::onCreated();
 
-        game->addDialog({"Pick the right shell by pressing 1,2 or 3", 2.0f});
+        game->addDialog({Message("ShellGamePick"), 2.0f});
         didDisplayShell = false;
+        isScrambling = true;
+        game->getTimers().setAfter(4.0f, this, isScrambling, false);
 
         // Randomly select a shell to put the gem under
-        int gemWillBeUnder = rand() % shellCount;
+        int gemWillBeUnder = getContext().randomInt(shellCount);
 
         const auto spriteHalfSize = SPRITE_SIZE * 0.5f;
         const auto spritePositionY = SCREEN_HEIGHT * 0.5f - spriteHalfSize;
@@ -28,25 +53,26 @@ public:
 
         const auto totalWidth = (shellCount * SPRITE_SIZE) + ((shellCount - 1) * padding);
 
+        gem->game = game;
+        gem->onCreated();
+
         for (int i = 0; i < shellCount; i++)
         {
-            auto *shell = new ShellNode(game);
+            auto *shell = shells[i];
+            shell->game = game;
+
+            auto position = shell->position;
+            position.y = spritePositionY;
+            position.x = screenHalfWidth - totalWidth * 0.5f + (i * (SPRITE_SIZE + padding));
+            shell->setPosition(position);
             shell->onCreated();
 
             if (i == gemWillBeUnder)
             {
-                auto *gem = new GemNode(game);
-                gem->onCreated();
-                gem->parent = shell;
+                gem->setParent(shell);
                 shell->addChild(gem);
             }
 
-            auto position = shell->position;
-            position.y = spritePositionY;
-            position.x = screenHalfWidth - totalWidth * 0.5f + (i * (SPRITE_SIZE + padding));
-            shell->setPosition(position);
-
-            shell->name = "shell_" + std::to_string(i + 1);
             shell->display();
 
             addChild(shell);
@@ -57,15 +83,14 @@ public:
     {
         MiniGame::onUpdated(fElapsedTime);
 
-        if (moveTime < 4)
+        if (isScrambling)
         {
-            moveTime += fElapsedTime;
             scrambleShells();
         }
-        else if (!game->getFlag("DidTeachHowToPlayShellGame"))
+        else if (!game->getFlag(Flag("DidTeachHowToPlayShellGame")))
         {
-            game->addDialog({"Press 1, 2 or 3 to select a shell", 3.0f});
-            game->setFlag("DidTeachHowToPlayShellGame", true);
+            game->addDialog({Message("ShellGameKeys"), 3.0f});
+            game->setFlag(Flag("DidTeachHowToPlayShellGame"), true);
         }
         else
         {
@@ -82,7 +107,7 @@ public:
 
         for (int i = 0; i < shellCount; i++)
         {
-            auto *shell = getChildOfType<ShellNode>("shell_" + std::to_string(i + 1));
+            auto *shell = getChildOfType<ShellNode>(shellNames[i]);
             if (!shell)
             {
                 return;
@@ -96,14 +121,14 @@ public:
     {
         for (int i = 0; i < shellCount; i++)
         {
-            auto *shell = getChildOfType<ShellNode>("shell_" + std::to_string(i + 1));
+            auto *shell = getChildOfType<ShellNode>(shellNames[i]);
             if (!shell)
             {
                 return;
             }
 
             auto key = olc::Key::K1 + i;
-            if (Pressed(key))
+            if (getContext().Pressed(key))
             {
                 finishGame(isTheRightShell(i + 1));
                 return;
@@ -113,7 +138,7 @@ public:
 
     bool isTheRightShell(int shellIndex)
     {
-        auto *shell = getChildOfType<ShellNode>("shell_" + std::to_string(shellIndex));
+        auto *shell = getChildOfType<ShellNode>(shellNames[shellIndex - 1]);
         if (!shell)
         {
             return false;
@@ -149,9 +174,9 @@ public:
 
     void scrambleShells()
     {
-        auto *shell1 = getChildOfType<ShellNode>("shell_1");
-        auto *shell2 = getChildOfType<ShellNode>("shell_2");
-        auto *shell3 = getChildOfType<ShellNode>("shell_3");
+        auto *shell1 = getChildOfType<ShellNode>(shellNames[0]);
+        auto *shell2 = getChildOfType<ShellNode>(shellNames[1]);
+        auto *shell3 = getChildOfType<ShellNode>(shellNames[2]);
 
         if (!shell1 || !shell2 || !shell3)
         {
@@ -163,17 +188,14 @@ public:
             return;
         }
 
-        std::random_device r;
-        std::seed_seq seed{r(), r(), r(), r(), r(), r(), r(), r()};
-        std::mt19937 eng(seed);
-
-        auto shells = std::vector<ShellNode *>{shell1, shell2, shell3};
-        std::shuffle(shells.begin(), shells.end(), eng);
+        // The world's generator, seeding a fresh one each move reads the OS entropy source
+        std::array<ShellNode *, 3> order = {shell1, shell2, shell3};
+        std::shuffle(order.begin(), order.end(), getContext().random);
 
         for (int i = 0; i < shellCount; i++)
         {
-            auto *shell = shells[i];
-            auto *nextShell = shells[(i + 1) % shellCount];
+            auto *shell = order[i];
+            auto *nextShell = order[(i + 1) % shellCount];
             switchShellPosition(shell, nextShell);
         }
     }
@@ -2,20 +2,29 @@
 
 using namespace olc::utils::geom2d;
 
+/**
+ * What NPCs of one type share, made by their makePrefab.
+ */
+struct NPCPrefab : EntityPrefab
+{
+    ClipId idleClip = NoClip;
+    ClipId villainClip = NoClip;
+};
+
 class CoreNPC : public EntityNode
 {
+public:
+    static constexpr bool Streamed = false;
+
 protected:
-    AnimatedAssetProvider *animProvider = nullptr;
-    bool isPlayingChat = false;
+    const NPCPrefab *prefab = nullptr;
+    SpriteAnimator animator;
+    ScriptHandle conversation;
 
 public:
-    CoreNPC(const ldtk::Entity &entity, GameNode *game) : EntityNode(entity, game)
+    CoreNPC(const EntitySpawn &spawn, GameNode *game) : EntityNode(spawn, game)
     {
-    }
-
-    ~CoreNPC()
-    {
-        delete animProvider;
+        declareType<CoreNPC>();
     }
 
     void onCreated() override
@@ -25,7 +34,13 @@ public:
         // NPCs dont have physics, so we need to adjust their position
         position.y += 8;
 
-        animProvider = new AnimatedAssetProvider(position, getSpriteDrawPosition());
+        prefab = &game->getPrefabs().get<NPCPrefab>(getTypeId(), [this](NPCPrefab &prefab)
+                                                    { buildPrefab(prefab); });
+
+        // Stamped from the prefab, nothing here allocates
+        animator = prefab->animator;
+        animator.setOffset(getSpriteDrawPosition());
+        game->getInput().subscribe(InputAction::Enter, this, InputPriority::NPC);
     }
 
     void onUpdated(float fElapsedTime) override
@@ -36,12 +51,6 @@ public:
         if (!camera->IsOnScreen(position))
             return;
 
-        if (isPlayingChat && !game->hasPersistentDialogShowing())
-        {
-            isPlayingChat = false;
-            onChatEnded();
-        }
-
         onScreen(fElapsedTime);
     }
 
@@ -63,8 +72,13 @@ public:
 
     virtual void onInteracted(PlayerNode *player) {}
 
-    virtual void onChatEnded()
+    /**
+     * Fills in the prefab of this node's class, called once per world by
+     * the first node of the class to be created. Most NPCs just blink.
+     */
+    virtual void makePrefab(NPCPrefab &prefab)
     {
+        prefab.idleClip = prefab.clips.add(2.0f, {{}, {1, 0}});
     }
 
     virtual void onDamage() {}
@@ -73,24 +87,44 @@ public:
     {
         auto drawPosition = this->position;
         camera->WorldToScreen(drawPosition);
-        animProvider->Update(fElapsedTime);
-        auto *options = animProvider->GetAssetOptions();
+        animator.Update(fElapsedTime);
+        auto *options = animator.GetAssetOptions();
         options->position = drawPosition;
-        Image(spritesProvider, options);
+        getContext().Image(spritesProvider, options);
     }
 
-    void chat(const std::vector<std::string> msgs)
+    bool isTalking()
     {
-        if (isPlayingChat)
-        {
-            return;
-        }
+        return game->getScripts().isRunning(conversation);
+    }
 
-        isPlayingChat = true;
+    /**
+     * Starts script as this NPC's conversation, unless one is still going.
+     */
+    void talk(Script script)
+    {
+        if (!isTalking())
+            conversation = game->getScripts().start(this, std::move(script));
+    }
+
+    /**
+     * Queues msgs as persistent dialogs, co_await it to wait until the
+     * player went through all of them.
+     */
+    template <typename... Messages>
+    auto say(Messages... msgs)
+    {
         uint8_t dialogId = 10;
+        (game->addDialog({msgs, 0.0f, false, true, dialogId++}), ...);
+        return game->waitForDialogs();
+    }
 
-        for (auto &msg : msgs)
-            game->addDialog({msg, 0.0f, false, true, dialogId++});
+private:
+    void buildPrefab(NPCPrefab &prefab)
+    {
+        makePrefab(prefab);
+        prefab.animator = SpriteAnimator(&prefab.clips, getSpriteDrawPosition());
+        prefab.animator.Play(prefab.idleClip);
     }
 };
 
@@ -100,35 +134,30 @@ public:
 
 class FlowerNode;
 
-enum class CurrentChat
-{
-    FLOWER,
-    TURN_TO_VILLAIN,
-    TURN_TO_VILLAIN_COMPLETE,
-    NONE,
-};
-
 class AndersonNPC : public CoreNPC
 {
 private:
-    uint8_t flowerDialogId = 10;
-    CurrentChat currentChat = CurrentChat::NONE;
     bool isVillain = false;
-    float animTurnToVillainDeltaTime = 0.0f;
+    bool isFlyingAway = false;
 
 public:
-    AndersonNPC(const ldtk::Entity &entity, GameNode *game) : CoreNPC(entity, game)
+    AndersonNPC(const EntitySpawn &spawn, GameNode *game) : CoreNPC(spawn, game)
     {
+        declareType<AndersonNPC>();
     }
 
     void onCreated() override
     {
         CoreNPC::onCreated();
-        animProvider->AddAnimation("idle", 2.0f, {{}, {1, 0}});
-        animProvider->AddAnimation("villainIdle", 1.0f, {{2, 0}});
-        animProvider->PlayAnimation("idle");
-        currentChat = CurrentChat::NONE;
+        conversation = ScriptHandle();
         isVillain = false;
+        isFlyingAway = false;
+    }
+
+    void makePrefab(NPCPrefab &prefab) override
+    {
+        CoreNPC::makePrefab(prefab);
+        prefab.villainClip = prefab.clips.add(1.0f, {{2, 0}});
     }
 
     void onInteracted(PlayerNode *player) override
@@ -140,96 +169,59 @@ public:
             return;
         }
 
-        currentChat = CurrentChat::FLOWER;
+        talk(turnToVillain());
     }
 
-    void onChatEnded() override
+    void onSnapshot(SnapshotWriter &writer) const override
     {
-        switch (currentChat)
-        {
-        case CurrentChat::FLOWER:
-            currentChat = CurrentChat::TURN_TO_VILLAIN;
-            break;
-
-        case CurrentChat::TURN_TO_VILLAIN:
-            game->addDialog({"ACT 1: The villain", 4.0f, true, false});
-            currentChat = CurrentChat::TURN_TO_VILLAIN_COMPLETE;
-            animProvider->PlayAnimation("villainIdle");
-            isVillain = true;
-            break;
-
-        case CurrentChat::TURN_TO_VILLAIN_COMPLETE:
-            currentChat = CurrentChat::NONE;
-            break;
-
-        case CurrentChat::NONE:
-            break;
-        }
+        CoreNPC::onSnapshot(writer);
+        writer.write(isVillain);
+        writer.write(isFlyingAway);
+    }
+
+    void onRestore(SnapshotReader &reader) override
+    {
+        CoreNPC::onRestore(reader);
+        reader.read(isVillain);
+        reader.read(isFlyingAway);
+        animator.Play(isVillain ? prefab->villainClip : prefab->idleClip);
     }
 
     void onScreen(float fElapsedTime) override
     {
         CoreNPC::onScreen(fElapsedTime);
 
-        switch (currentChat)
-        {
-        case CurrentChat::FLOWER:
-            playSmellFlowerDialog();
-            break;
-
-        case CurrentChat::TURN_TO_VILLAIN:
-            playTurnToVillainDialog();
-            break;
-
-        case CurrentChat::TURN_TO_VILLAIN_COMPLETE:
-            playTurnToVillainCompleteDialog();
-            break;
-
-        case CurrentChat::NONE:
-        default:
-            break;
-        }
-
-        if (isVillain && currentChat == CurrentChat::NONE)
-        {
-            animTurnToVillainDeltaTime += fElapsedTime;
-
-            if (animTurnToVillainDeltaTime > 1.0f)
-                position.y -= 200 * fElapsedTime;
-        }
+        if (isFlyingAway)
+            position.y -= 200 * fElapsedTime;
     }
 
 private:
-    void playSmellFlowerDialog()
-    {
-        chat({
-            "ANDERSON: Hello, I'm Anderson. I like cookies",
-            "ANDERSON: Oh, you have a blue flower, can I smell it?",
-            "YOU: Actually, it's purple",
-            "ANDERSON: Bruh... Anyway, can I smell it?",
-            "YOU: Sure, go ahead",
-        });
-    }
+    Script turnToVillain()
+    {
+        co_await say(
+            Message("AndersonHello"),
+            Message("AndersonAsksFlower"),
+            Message("YouFlowerIsPurple"),
+            Message("AndersonAsksAgain"),
+            Message("YouGoAhead"));
+
+        co_await say(
+            Message("AndersonFeelsWeird"),
+            Message("AndersonTurning"));
+
+        game->addDialog({Message("ActOneVillain"), 4.0f, true, false});
+        animator.Play(prefab->villainClip);
+        isVillain = true;
+        game->enableLevelPortal();
 
-    void playTurnToVillainDialog()
-    {
-        chat({
-            "ANDERSON: I Think the flower is making me feel weird",
-            "ANDERSON: I'm turning into a villain",
-        });
-    }
+        co_await say(Message("AndersonIsVillain"));
 
-    void playTurnToVillainCompleteDialog()
-    {
-        chat({
-            "ANDERSON: I'm a villain now, I will destroy the world",
-        });
-        game->enableLevelPortal();
+        // A moment to take in the new look before leaving
+        co_await game->waitSeconds(1.0f);
+        isFlyingAway = true;
     }
 };
 
-REGISTER_NODE_TYPE(AndersonNPC, "anderson");
-
 #pragma endregion Anderson - NPC
 
 #pragma region Enemy - BEE
@@ -245,8 +237,11 @@ private:
     bool harmless = false;
 
 public:
-    BeeEnemy(const ldtk::Entity &entity, GameNode *game) : CoreNPC(entity, game)
+    static constexpr bool Streamed = true;
+
+    BeeEnemy(const EntitySpawn &spawn, GameNode *game) : CoreNPC(spawn, game)
     {
+        declareType<BeeEnemy>();
     }
 
     bool isHarmless()
@@ -254,26 +249,58 @@ public:
         return harmless;
     }
 
+    uint8_t onStreamOut() override
+    {
+        return harmless;
+    }
+
+    void onStreamIn(uint8_t state) override
+    {
+        // Calmed down before it was streamed out, already counted then
+        if (state && !harmless)
+            calmDown();
+    }
+
+    void onSnapshot(SnapshotWriter &writer) const override
+    {
+        CoreNPC::onSnapshot(writer);
+        writer.write(initialPosition);
+        writer.write(travelTo);
+        writer.write(delta);
+        writer.write(direction);
+        writer.write(harmless);
+    }
+
+    void onRestore(SnapshotReader &reader) override
+    {
+        CoreNPC::onRestore(reader);
+        reader.read(initialPosition);
+        reader.read(travelTo);
+        reader.read(delta);
+        reader.read(direction);
+        reader.read(harmless);
+        animator.setTint(harmless ? olc::WHITE : olc::CYAN);
+    }
+
+    void makePrefab(NPCPrefab &prefab) override
+    {
+        prefab.idleClip = prefab.clips.add(4.9f, {{}, {1, 0}, {}, {1, 0}});
+    }
+
     void onCreated() override
     {
         CoreNPC::onCreated();
-        animProvider->setTint(olc::CYAN);
-        animProvider->AddAnimation("idle", 4.9f, {{}, {1, 0}, {}, {1, 0}});
-        animProvider->PlayAnimation("idle");
-        animProvider->Update(0.5f + (rand() % 10) / 10.0f);
-        auto initialPosition = entity.getPosition();
-        const auto &travelToField = entity.getField<ldtk::FieldType::Point>("travel");
-        position = olc::vf2d({static_cast<float>(initialPosition.x), static_cast<float>(initialPosition.y)});
+        animator.setTint(olc::CYAN);
+        animator.Update(0.5f + getContext().randomInt(10) / 10.0f);
+        auto &fields = spawn.getFields<BeeFields>();
+        auto initialPosition = spawn.position;
+        position = initialPosition;
         this->initialPosition = position;
+        harmless = !fields.isMad;
 
-        // get property isMad
-        const auto &isMadField = entity.getField<ldtk::FieldType::Bool>("is_mad");
-        harmless = isMadField.is_null() || !isMadField.value();
-
-        if (!travelToField.is_null())
+        if (fields.hasTravel)
         {
-            ldtk::IntPoint travelTo = travelToField.value();
-            this->travelTo = olc::vf2d({static_cast<float>(travelTo.x), static_cast<float>(travelTo.y)});
+            this->travelTo = olc::vf2d({static_cast<float>(fields.travel.x), static_cast<float>(fields.travel.y)});
             this->travelTo *= SPRITE_SIZE;
         }
 
@@ -290,7 +317,15 @@ public:
 
     void onDamage() override
     {
-        animProvider->setTint(olc::WHITE);
+        if (!harmless)
+            game->getQuests().add(QuestCounter::MadBees, -1);
+
+        calmDown();
+    }
+
+    void calmDown()
+    {
+        animator.setTint(olc::WHITE);
         harmless = true;
     }
 
@@ -343,7 +378,7 @@ public:
         }
 
         // flipping the sprite based on the direction
-        animProvider->GetAssetOptions()->scale.x = direction;
+        animator.GetAssetOptions()->scale.x = direction;
 
         // if direction is negative we need to adjust the position by adding the sprite size
         if (direction < 0)
@@ -357,136 +392,91 @@ public:
         computeDamageToPlayer();
     }
 };
-REGISTER_NODE_TYPE(BeeEnemy, "bee");
 
 #pragma endregion Enemy - BEE
 
 #pragma region Erik - NPC
 
-enum class ErikCurrentChat
-{
-    HELLO,
-    THANKS,
-    NONE,
-};
-
 class ErikNPC : public CoreNPC
 {
 private:
-    ErikCurrentChat currentChat = ErikCurrentChat::NONE;
     bool didShowSecret = false;
     bool didClearBees = false;
 
 public:
-    ErikNPC(const ldtk::Entity &entity, GameNode *game) : CoreNPC(entity, game)
+    ErikNPC(const EntitySpawn &spawn, GameNode *game) : CoreNPC(spawn, game)
     {
+        declareType<ErikNPC>();
     }
 
     void onCreated() override
     {
         CoreNPC::onCreated();
-        animProvider->AddAnimation("idle", 2.0f, {{}, {1, 0}});
-        animProvider->PlayAnimation("idle");
+
+        conversation = ScriptHandle();
+        didShowSecret = false;
+        didClearBees = false;
+        game->getQuests().onCompleted(QuestCounter::MadBees, this, [this]()
+                                      { didClearBees = true; });
     }
 
     void onInteracted(PlayerNode *player) override
     {
-        if (didClearBees)
-        {
-            currentChat = ErikCurrentChat::THANKS;
-            return;
-        }
-
-        currentChat = ErikCurrentChat::HELLO;
+        talk(didClearBees ? thank() : askForHelp());
     }
 
-    void onScreen(float fElapsedTime) override
+    void onSnapshot(SnapshotWriter &writer) const override
     {
-        CoreNPC::onScreen(fElapsedTime);
-        evaluateIfCompletedTask();
-
-        switch (currentChat)
-        {
-        case ErikCurrentChat::HELLO:
-            playHelloDialog();
-            break;
-
-        case ErikCurrentChat::THANKS:
-            playThanksDialog();
-            break;
-
-        case ErikCurrentChat::NONE:
-        default:
-            break;
-        }
+        CoreNPC::onSnapshot(writer);
+        writer.write(didShowSecret);
+        writer.write(didClearBees);
     }
 
-    void onChatEnded() override
+    void onRestore(SnapshotReader &reader) override
     {
-        if (didClearBees && !didShowSecret)
-        {
-            game->enableLevelPortal();
-            didShowSecret = true;
-        }
+        CoreNPC::onRestore(reader);
+        reader.read(didShowSecret);
+        reader.read(didClearBees);
 
-        currentChat = ErikCurrentChat::NONE;
+        // Bees calmed down after the snapshot are mad again
+        if (!didClearBees)
+            game->getQuests().onCompleted(QuestCounter::MadBees, this, [this]()
+                                          { didClearBees = true; });
     }
 
 private:
-    void playHelloDialog()
+    Script askForHelp()
     {
-        chat({
-            "ERIK: Hello, Anderson got my bees angry",
-            "ERIK: Please help me to calm them down",
-            "ERIK: I'll tell you a secret if you do it",
-            "YOU: Sure, I'll help you",
-        });
+        co_await say(
+            Message("ErikHello"),
+            Message("ErikAsksHelp"),
+            Message("ErikPromisesSecret"),
+            Message("YouWillHelp"));
     }
 
-    void playThanksDialog()
+    Script thank()
     {
         if (didShowSecret)
         {
-            chat({
-                "ERIK: Go save the world, hero!",
-            });
+            co_await say(Message("ErikGoSaveTheWorld"));
 
-            return;
+            co_return;
         }
 
-        chat({
-            "ERIK: Thanks for helping me with the bees",
-            "ERIK: The secret is that... I'm a bee too",
-            "ERIK: Lol, just kidding, I'm a human",
-            "ERIK: The secret is that...",
-            "ERIK: I can open portals, like in rick and morty",
-            "ERIK: I'll open one for you to the city",
-            "ERIK: In the city you might find the hex guardian",
-            "ERIK: He may provide you with the infinity gem that\nyou need to bring balance to the world",
-        });
-    }
-
-private:
-    void evaluateIfCompletedTask()
-    {
-
-        if (didShowSecret)
-            return;
-
-        didClearBees = false;
-
-        auto bees = game->getOnScreenChildrenOfType<BeeEnemy>(false);
-
-        for (auto &bee : bees)
-        {
-            if (!bee->isHarmless())
-                return;
-        }
+        co_await say(
+            Message("ErikThanks"),
+            Message("ErikIsABee"),
+            Message("ErikJustKidding"),
+            Message("ErikTheSecretIs"),
+            Message("ErikOpensPortals"),
+            Message("ErikPortalToCity"),
+            Message("ErikHexGuardian"),
+            Message("ErikInfinityGem"));
 
-        didClearBees = true;
+        game->enableLevelPortal();
+        didShowSecret = true;
     }
 };
-REGISTER_NODE_TYPE(ErikNPC, "erik");
 
 #pragma endregion Erik - NPC
 
@@ -495,22 +485,19 @@ REGISTER_NODE_TYPE(ErikNPC, "erik");
 class MartinNPC : public CoreNPC
 {
 private:
-    bool didSetMiniGame = false;
     bool didPlayDialog = false;
-    bool didPlaySecondDialog = false;
     bool didWin = false;
 
 public:
-    MartinNPC(const ldtk::Entity &entity, GameNode *game) : CoreNPC(entity, game)
+    MartinNPC(const EntitySpawn &spawn, GameNode *game) : CoreNPC(spawn, game)
     {
+        declareType<MartinNPC>();
     }
 
     void onCreated() override
     {
         CoreNPC::onCreated();
-        animProvider->AddAnimation("idle", 2.0f, {{}, {1, 0}});
-        animProvider->PlayAnimation("idle");
-        didSetMiniGame = false;
+        conversation = ScriptHandle();
         didPlayDialog = false;
         didWin = false;
     }
@@ -518,68 +505,32 @@ public:
     void onAllCreated() override
     {
         CoreNPC::onAllCreated();
-        game->setFlag("showGem", false);
+        game->setFlag(Flag("showGem"), false);
     }
 
     void onInteracted(PlayerNode *player) override
     {
         if (didWin)
         {
-            chat({"MARTIN: Thinking..."});
+            talk(think());
             return;
         }
 
-        if (!didPlayDialog)
-        {
-            didPlayDialog = true;
-            playHelloDialog();
-        }
-        else if (!didPlaySecondDialog)
-        {
-            didPlaySecondDialog = true;
-            playRetryDialog();
-        }
-    }
-
-    void onChatEnded() override
-    {
-        didPlaySecondDialog = false;
-
-        if (didSetMiniGame)
-            return;
-
-        didSetMiniGame = true;
-        game->setMiniGame("ShellGame");
+        talk(challenge());
     }
 
-    void playHelloDialog()
+    void onSnapshot(SnapshotWriter &writer) const override
     {
-        chat({
-            "MARTIN: Thinking... 1/2 (with eyes closed)",
-            "MARTIN: Thinking... 2/2 (with eyes closed)",
-            "MARTIN: Hello, I'm Martin, the Hex Guardian",
-            "MARTIN: I'm here to protect the infinity gem",
-            "MARTIN: I know what you are thinking...",
-            "MARTIN: And yes...",
-            "MARTIN: My armor is fully made of gold",
-            "YOU: I wasn't thinking that",
-            "MARTIN: I know, I'm just messing with you",
-            "YOU: Plus, it looks like plastic",
-            "MARTIN: We are in the ancient times, we don't have plastic yet",
-            "MARTIN: Anyway, you can't have the gem",
-            "MARTIN: You need to prove yourself first",
-            "MARTIN: By playing a shell game... with me",
-            "MARTIN: If you guess where the gem is, you can have it",
-            "YOU: That sounds fair",
-        });
+        CoreNPC::onSnapshot(writer);
+        writer.write(didPlayDialog);
+        writer.write(didWin);
     }
 
-    void playRetryDialog()
+    void onRestore(SnapshotReader &reader) override
     {
-        didSetMiniGame = false;
-        chat({
-            "MARTIN: Fine, I can give you another chance",
-        });
+        CoreNPC::onRestore(reader);
+        reader.read(didPlayDialog);
+        reader.read(didWin);
     }
 
     void onMiniGameOver(std::string name, bool didWin) override
@@ -589,22 +540,62 @@ public:
 
         this->didWin = didWin;
 
+        if (didWin)
+            this->game->setFlag(Flag("showGem"), true);
+
+        talk(announce(didWin));
+    }
+
+private:
+    Script think()
+    {
+        co_await say(Message("MartinThinking"));
+    }
+
+    Script challenge()
+    {
+        if (!didPlayDialog)
+        {
+            didPlayDialog = true;
+            co_await say(
+                Message("MartinThinkingOne"),
+                Message("MartinThinkingTwo"),
+                Message("MartinHello"),
+                Message("MartinProtectsGem"),
+                Message("MartinKnowsThoughts"),
+                Message("MartinAndYes"),
+                Message("MartinGoldArmor"),
+                Message("YouWasNotThinking"),
+                Message("MartinMessingWithYou"),
+                Message("YouLooksLikePlastic"),
+                Message("MartinNoPlasticYet"),
+                Message("MartinCantHaveGem"),
+                Message("MartinProveYourself"),
+                Message("MartinShellGame"),
+                Message("MartinGuessTheGem"),
+                Message("YouSoundsFair"));
+        }
+        else
+        {
+            co_await say(Message("MartinAnotherChance"));
+        }
+
+        game->setMiniGame("ShellGame");
+    }
+
+    Script announce(bool didWin)
+    {
         if (didWin)
         {
-            this->game->setFlag("showGem", true);
-            chat({
-                "MARTIN: You won the game, here is the gem",
-                "MARTIN: Use it wisely",
-            });
+            co_await say(
+                Message("MartinYouWon"),
+                Message("MartinUseItWisely"));
         }
         else
         {
-            chat({
-                "MARTIN: You lost the game. I'll keep the gem",
-            });
+            co_await say(Message("MartinYouLost"));
         }
     }
 };
-REGISTER_NODE_TYPE(MartinNPC, "martin");
 
 #pragma endregion Martin - NPC
\ No newline at end of file
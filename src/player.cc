@@ -1,9 +1,30 @@
 
+/**
+ * The player's clips and sounds, made once per world.
+ */
+struct PlayerPrefab : EntityPrefab
+{
+    ClipId idleClip = NoClip;
+    ClipId walkClip = NoClip;
+    ClipId jumpClip = NoClip;
+    ClipId fallClip = NoClip;
+    ClipId deadClip = NoClip;
+    Sound *damageSound = nullptr;
+    Sound *coinLostSound = nullptr;
+    Sound *jumpSound = nullptr;
+    Sound *walkSound = nullptr;
+};
+
 class PlayerNode : public EntityNode
 {
+public:
+    static constexpr bool Streamed = false;
+    static constexpr bool Sleeps = false;
+
 private:
     olc::vf2d checkpoint;
-    AnimatedAssetProvider *animations = nullptr;
+    const PlayerPrefab *prefab = nullptr;
+    SpriteAnimator animator;
     olc::vf2d velocity = {0, 0};
     bool isOnGround = false;
     bool lockRight = false;
@@ -17,26 +38,14 @@ private:
     int selectedIndex = -1;
     CoreNode *child = nullptr;
     bool canMove = true;
-    float immortalityTime = 0.0f;
-    float timeoutTillPlayWalkSound = 0.0f;
-
-    Sound *damageSound = nullptr;
-    Sound *coinLostSound = nullptr;
-    Sound *jumpSound = nullptr;
-    Sound *walkSound = nullptr;
+    bool immortal = false;
+    TimerHandle immortalityTimer;
+    TimerHandle walkSoundTimer;
 
 public:
-    PlayerNode(const ldtk::Entity &entity, GameNode *game) : EntityNode(entity, game)
-    {
-    }
-
-    ~PlayerNode() override
+    PlayerNode(const EntitySpawn &spawn, GameNode *game) : EntityNode(spawn, game)
     {
-        delete animations;
-        delete damageSound;
-        delete coinLostSound;
-        delete jumpSound;
-        delete walkSound;
+        declareType<PlayerNode>();
     }
 
     uint8_t getLives()
@@ -110,16 +119,12 @@ public:
     {
         EntityNode::onCreated();
 
-        // Animation definitions
-        this->animations = new AnimatedAssetProvider(position, getSpriteDrawPosition(), {1, 1}, {SPRITE_SIZE, SPRITE_SIZE}, olc::WHITE);
-
-        this->animations->AddAnimation("idle", 4.0, {{}, {1, 0}});
-        this->animations->AddAnimation("walk", 30.0, {{}, {3, 0}, {3, 0}, {3, 0}, {}, {1, 0}, {2, 0}, {2, 0}, {1, 0}});
-        this->animations->AddAnimation("jump", 4.0, {{4, 0}});
-        this->animations->AddAnimation("fall", 4.0, {{5, 0}});
-        this->animations->AddAnimation("dead", 4.0, {{6, 0}});
+        prefab = &game->getPrefabs().get<PlayerPrefab>(getTypeId(), [this](PlayerPrefab &prefab)
+                                                       { makePrefab(prefab); });
 
-        this->animations->PlayAnimation("idle");
+        // Stamped from the prefab, a new game doesn't load anything again
+        animator = prefab->animator;
+        animator.setOffset(getSpriteDrawPosition());
 
         camera->offset.x = SCREEN_WIDTH * 0.5;
         camera->offset.y = SCREEN_HEIGHT * 0.66 - 20;
@@ -128,12 +133,34 @@ public:
         storage = 1;
         money = 0;
         canMove = true;
-        immortalityTime = 0.0f;
+        immortal = false;
+
+        auto &input = game->getInput();
+        input.subscribe(InputAction::Up, this, InputPriority::Player);
+        input.subscribe(InputAction::Down, this, InputPriority::Player);
+        input.subscribe(InputAction::Left, this, InputPriority::Player);
+        input.subscribe(InputAction::Right, this, InputPriority::Player);
+
+        auto &scheduler = game->getScheduler();
+        scheduler.add<&PlayerNode::stepInput>(UpdatePhase::Input, this);
+        scheduler.add<&PlayerNode::stepPhysics>(UpdatePhase::Physics, this);
+        scheduler.add<&PlayerNode::stepAnimation>(UpdatePhase::Animation, this);
+    }
 
-        damageSound = new Sound("assets/sfx/damage.wav", 1);
-        coinLostSound = new Sound("assets/sfx/coin_down.wav", 2);
-        jumpSound = new Sound("assets/sfx/jump.wav", 3);
-        walkSound = new Sound("assets/sfx/walk.wav", 4);
+    void makePrefab(PlayerPrefab &prefab)
+    {
+        prefab.idleClip = prefab.clips.add(4.0f, {{}, {1, 0}});
+        prefab.walkClip = prefab.clips.add(30.0f, {{}, {3, 0}, {3, 0}, {3, 0}, {}, {1, 0}, {2, 0}, {2, 0}, {1, 0}});
+        prefab.jumpClip = prefab.clips.add(4.0f, {{4, 0}});
+        prefab.fallClip = prefab.clips.add(4.0f, {{5, 0}});
+        prefab.deadClip = prefab.clips.add(4.0f, {{6, 0}});
+        prefab.animator = SpriteAnimator(&prefab.clips, getSpriteDrawPosition());
+        prefab.animator.Play(prefab.idleClip);
+
+        prefab.damageSound = prefab.loadSound(getContext(), "assets/sfx/damage.wav", 1);
+        prefab.coinLostSound = prefab.loadSound(getContext(), "assets/sfx/coin_down.wav", 2);
+        prefab.jumpSound = prefab.loadSound(getContext(), "assets/sfx/jump.wav", 3);
+        prefab.walkSound = prefab.loadSound(getContext(), "assets/sfx/walk.wav", 4);
     }
 
     void disableMovement()
@@ -146,27 +173,25 @@ public:
         canMove = true;
     }
 
-    void onUpdated(float fElapsedTime) override
+    void stepInput([[maybe_unused]] float fElapsedTime)
     {
-        if (camera->IsOfflimits(position))
-        {
-            onLoseLife();
-            return;
-        }
-
-        immortalityTime -= fElapsedTime;
-
-        if (immortalityTime < 0)
-            immortalityTime = 0;
-
         canMove = lives > 0 && !game->hasPersistentDialogShowing();
 
         if (game->hasPersistentDialogShowing())
         {
-            animations->PlayAnimation("idle", false);
+            animator.Play(prefab->idleClip, false);
         }
 
         invokeItemFromStorage();
+    }
+
+    void stepPhysics(float fElapsedTime)
+    {
+        if (camera->IsOfflimits(position))
+        {
+            onLoseLife();
+            return;
+        }
 
         acceleration.y += 9.8f * fElapsedTime;
 
@@ -189,63 +214,69 @@ public:
         computeCollisions();
         position += velocity * fElapsedTime;
 
-        if (lockLeft || lockRight || Released(LEFT_KEY) && Released(RIGHT_KEY))
+        if (lockLeft || lockRight || (getContext().Released(LEFT_KEY) && getContext().Released(RIGHT_KEY)))
             velocity.x = 0;
+    }
 
-        // Updating the animations
+    void stepAnimation(float fElapsedTime)
+    {
         if (canMove)
         {
             if (isOnGround)
             {
                 if (velocity.x != 0)
                 {
-                    animations->PlayAnimation("walk", false);
-                    if (timeoutTillPlayWalkSound <= 0)
-                    {
-                        walkSound->Play(false, false);
-                        timeoutTillPlayWalkSound = 0.5f;
-                    }
-                    else
+                    animator.Play(prefab->walkClip, false);
+                    if (!game->getTimers().isPending(walkSoundTimer))
                     {
-                        timeoutTillPlayWalkSound -= fElapsedTime;
+                        prefab->walkSound->Play(false, false);
+
+                        // Only a cooldown, nothing to run when it's over
+                        walkSoundTimer = game->getTimers().after(0.5f, this, []() {});
                     }
                 }
                 else
                 {
-                    animations->PlayAnimation("idle", false);
-                    walkSound->SetPlayed(false);
+                    animator.Play(prefab->idleClip, false);
+                    prefab->walkSound->SetPlayed(false);
                 }
             }
             else
             {
                 if (velocity.y < 0)
                 {
-                    animations->PlayAnimation("jump", false);
+                    animator.Play(prefab->jumpClip, false);
                 }
                 else if (velocity.y > 0)
                 {
-                    animations->PlayAnimation("fall", false);
+                    animator.Play(prefab->fallClip, false);
                 }
             }
         }
 
-        // Rendering the player
-        animations->Update(fElapsedTime);
+        animator.Update(fElapsedTime);
+    }
+
+    /**
+     * Render phase, the rest of the frame runs in the step* phases.
+     */
+    void onUpdated(float fElapsedTime) override
+    {
         olc::vf2d drawPosition = this->position;
         camera->WorldToScreen(drawPosition);
-        auto *options = animations->GetAssetOptions();
+        auto *options = animator.GetAssetOptions();
         options->position = drawPosition;
         auto scaleFactor = isFacingRight ? 1 : -1;
         auto positionFactor = isFacingRight ? 0 : 1;
         options->scale.x = scaleFactor;
         options->position.x += positionFactor * options->size.x;
 
-        if (immortalityTime > 0)
+        if (immortal)
             options->tint = olc::Pixel(255, 0, 0);
         else
             options->tint = olc::Pixel(255, 255, 255);
 
-        Image(spritesProvider, options);
+        getContext().Image(spritesProvider, options);
         EntityNode::onUpdated(fElapsedTime);
     }
 
@@ -254,6 +285,76 @@ public:
         this->checkpoint = checkpoint;
     }
 
+    olc::vf2d getCheckpoint()
+    {
+        return checkpoint;
+    }
+
+    void onSnapshot(SnapshotWriter &writer) const override
+    {
+        EntityNode::onSnapshot(writer);
+        writer.write(checkpoint);
+        writer.write(velocity);
+        writer.write(acceleration);
+        writer.write(jumpTime);
+        writer.write(isOnGround);
+        writer.write(isFacingRight);
+        writer.write(lives);
+        writer.write(money);
+        writer.write(storage);
+        writer.write(selectedIndex);
+        writer.write(canMove);
+        writer.write(game->getTimers().remaining(immortalityTimer));
+    }
+
+    void onRestore(SnapshotReader &reader) override
+    {
+        EntityNode::onRestore(reader);
+        reader.read(checkpoint);
+        reader.read(velocity);
+        reader.read(acceleration);
+        reader.read(jumpTime);
+        reader.read(isOnGround);
+        reader.read(isFacingRight);
+        reader.read(lives);
+        reader.read(money);
+        reader.read(storage);
+        reader.read(selectedIndex);
+        reader.read(canMove);
+
+        // The game dropped every timer, the one left running starts again
+        immortal = false;
+        if (float immortalFor = reader.read<float>(); immortalFor > 0.0f)
+            makeImmortal(immortalFor);
+
+        // Carried items were put back before the nodes were restored
+        child = selectedIndex >= 0 && selectedIndex < static_cast<int>(children.size()) ? children[selectedIndex] : nullptr;
+        animator.Play(lives > 0 ? prefab->idleClip : prefab->deadClip, false);
+    }
+
+    /**
+     * A save keeps the checkpoint and the player's stats. Loading one puts
+     * the player at the checkpoint, everything else starts afresh.
+     */
+    void onSaveGame(SaveDataWriter &writer) const override
+    {
+        writer.writeF32(checkpoint.x);
+        writer.writeF32(checkpoint.y);
+        writer.writeI8(lives);
+        writer.writeU8(money);
+        writer.writeU8(storage);
+    }
+
+    void onLoadGame(SaveDataReader &reader) override
+    {
+        checkpoint.x = reader.readF32();
+        checkpoint.y = reader.readF32();
+        lives = reader.readI8();
+        money = reader.readU8();
+        storage = reader.readU8();
+        position = checkpoint;
+    }
+
     olc::vf2d getDirection()
     {
         return {isFacingRight ? 1.0f : -1.0f, 0.0f};
@@ -277,7 +378,7 @@ public:
         {
             auto key = static_cast<olc::Key>(olc::Key::K1 + i);
             auto hasChild = children.size() > i;
-            if (Pressed(key))
+            if (getContext().Pressed(key))
             {
                 selectedIndex = i;
                 if (hasChild)
@@ -300,7 +401,7 @@ public:
         if (isOnGround)
         {
             jumpTime = 0.0f;
-            jumpSound->Play(false, true);
+            prefab->jumpSound->Play(false, true);
             this->velocity.y = -250;
             isOnGround = false;
         }
@@ -361,7 +462,7 @@ public:
         if (child != nullptr)
         {
             child->position = position;
-            moveChildToRoot(child, game);
+            game->queueMoveToRoot(child);
             child = nullptr;
             selectedIndex = -1;
         }
@@ -369,15 +470,15 @@ public:
 
     void onTakeDamage()
     {
-        if (immortalityTime > 0)
+        if (immortal)
             return;
 
         if (money > 0)
         {
-            immortalityTime = 1.0f;
+            makeImmortal(1.0f);
             money = 0;
-            damageSound->Play(false, true);
-            coinLostSound->Play(false, true);
+            prefab->damageSound->Play(false, true);
+            prefab->coinLostSound->Play(false, true);
             return;
         }
         else
@@ -393,20 +494,32 @@ public:
         }
         else
         {
-            immortalityTime = 1.0f;
+            // Only the player goes back, the world stays as it is
+            makeImmortal(1.0f);
             position = checkpoint;
             canMove = false;
             velocity = {0, 0};
             acceleration = {0, 0};
-            damageSound->Play(false, true);
+            prefab->damageSound->Play(false, true);
         }
     }
 
+    /**
+     * Ignores damage for the given seconds of game time.
+     */
+    void makeImmortal(float seconds)
+    {
+        auto &timers = game->getTimers();
+        timers.cancel(immortalityTimer);
+        immortal = true;
+        immortalityTimer = timers.setAfter(seconds, this, immortal, false);
+    }
+
     void onInstantDeath()
     {
         lives = 0;
         canMove = false;
-        animations->PlayAnimation("dead", false);
+        animator.Play(prefab->deadClip, false);
         game->onGameOver();
     }
 
@@ -510,13 +623,12 @@ public:
                     }
                 }
             }
-            if (DEBUG)
+            if (getContext().debug)
             {
                 auto pos = collider->pos;
                 this->camera->WorldToScreen(pos);
-                Rect(pos, collider->size, color);
+                getContext().Rect(pos, collider->size, color);
             }
         }
     }
 };
-REGISTER_NODE_TYPE(PlayerNode, "player")
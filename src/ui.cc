@@ -4,12 +4,13 @@ class UINode : public CoreNode
 private:
     AssetOptions *options = nullptr;
     AssetOptions *slotOptions = nullptr;
-    float coinDeltaTime = 0.0f;
+    float coinChangedAt = -1.0f;
     uint8_t previousCoins = 0;
 
 public:
     UINode(GameNode *game) : CoreNode("UI", game)
     {
+        declareType<UINode>();
     }
 
     ~UINode() override
@@ -23,6 +24,9 @@ public:
         CoreNode::onCreated();
         this->options = getOptions("base", {16, 16});
         this->slotOptions = getOptions("slot", {SPRITE_SIZE, SPRITE_SIZE});
+
+        // The game clock restarts with a new game
+        coinChangedAt = -1.0f;
     }
 
     void onUpdated(float fElapsedTime) override
@@ -41,10 +45,8 @@ public:
 
     AssetOptions *getOptions(const std::string &name, olc::vi2d size = {SPRITE_SIZE, SPRITE_SIZE})
     {
-        auto &uiOptions = game->getGameEnum("world");
-        auto &baseEnumValue = uiOptions[name];
-        auto &textureRect = baseEnumValue.getIconTextureRect();
-        return new AssetOptions({0, 0}, {textureRect.x, textureRect.y}, {1, 1}, size);
+        auto icon = game->getWorld().getIcon(name);
+        return new AssetOptions({0, 0}, icon, {1, 1}, size);
     }
 
 private:
@@ -54,12 +56,11 @@ private:
         auto *coinsOptions = options->Copy();
         if (coins != previousCoins)
         {
-            coinDeltaTime = 0.0f;
+            coinChangedAt = game->getTime();
             previousCoins = coins;
         }
 
-        if (coinDeltaTime < 0.2f)
-            coinDeltaTime += fElapsedTime;
+        float coinDeltaTime = std::clamp(game->getTime() - coinChangedAt, 0.0f, 0.2f);
 
         // interpolate the coinDeltaTime value so we can get a value between 1.0 and 0.6
         const float value = 0.6 + 0.4 * coinDeltaTime / 0.2;
@@ -71,8 +72,8 @@ private:
         coinsOptions->position += coinsOptions->size * 0.5 * (1 - value);
 
         auto coinsText = std::to_string(coins);
-        Image(game->spritesProvider, coinsOptions);
-        Text(coinsText, olc::WHITE, YAlign::BOTTOM, XAlign::LEFT, {1.5, 1.5}, {36, -12});
+        getContext().Image(game->spritesProvider, coinsOptions);
+        getContext().Text(coinsText, olc::WHITE, YAlign::BOTTOM, XAlign::LEFT, {1.5, 1.5}, {36, -12});
         delete coinsOptions;
     }
 
@@ -106,7 +107,7 @@ private:
             if (isSelected)
                 storageOptions->offset.x += storageOptions->size.x;
 
-            Image(game->spritesProvider, storageOptions);
+            getContext().Image(game->spritesProvider, storageOptions);
 
             if (i < childCount)
             {
@@ -116,14 +117,14 @@ private:
                 {
                     auto *storageChildOptions = child->thumbnail->Copy();
                     storageChildOptions->position = storageOptions->position;
-                    Image(game->spritesProvider, storageChildOptions);
+                    getContext().Image(game->spritesProvider, storageChildOptions);
                     delete storageChildOptions;
                 }
             }
             else
             {
                 const olc::vf2d scale = olc::vf2d{1, 1} * (isSelected ? 1.2f : 0.8f);
-                const auto textCenter = TextSize(std::to_string(i + 1)) * 0.5f * scale;
+                const auto textCenter = getContext().TextSize(std::to_string(i + 1)) * 0.5f * scale;
                 const auto textPosition = storageOptions->position + olc::vf2d{SPRITE_SIZE * 0.5f, SPRITE_SIZE * 0.5f} - textCenter;
 
                 // color semitransparent when not selected
@@ -134,7 +135,7 @@ private:
                     color.a = 100;
                 }
 
-                Text(std::to_string(i + 1), color, textPosition, scale);
+                getContext().Text(std::to_string(i + 1), color, textPosition, scale);
             }
 
             storageOptions->position.x += storageOptions->size.x;
@@ -154,7 +155,7 @@ private:
         for (int i = 0; i < lives; i++)
         {
             livesOptions->position.x -= factor;
-            Image(game->spritesProvider, livesOptions);
+            getContext().Image(game->spritesProvider, livesOptions);
         }
 
         delete livesOptions;